@@ -0,0 +1,268 @@
+/**
+ * \file Acquisition-engine.cpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include "Acquisition-engine.hpp"
+
+#include <cstring>
+#include <map>
+
+#include <unistd.h>
+
+#include <rtt/os/TimeService.hpp>
+
+namespace {
+
+/**
+ * Engines by name
+ */
+std::map<std::string, Acquisition_engine *> & registry(void) {
+	static std::map<std::string, Acquisition_engine *> Engines;
+	return Engines;
+}
+
+RTT::os::Mutex & registryMutex(void) {
+	static RTT::os::Mutex Mutex;
+	return Mutex;
+}
+
+}
+
+Acquisition_engine::Acquisition_engine(int scheduler, int priority,
+		double period, unsigned int cpu_affinity, std::string name) :
+		Thread(scheduler, priority, period, cpu_affinity, name), users(0), cycle(
+				0), trigger(NULL), triggering(0), name(name) {
+	for (int i = 0; i < ENGINE_MAX_BOARDS; ++i)
+		ready[i] = false;
+
+	memset(&acquired, 0, sizeof(acquired));
+	group.write(acquired);
+}
+
+Acquisition_engine::~Acquisition_engine() {
+	stop();
+}
+
+Acquisition_engine * Acquisition_engine::attach(std::string Name,
+		std::string Member, Interface_thread * Board, int scheduler,
+		int priority, double period, unsigned int cpu_affinity) {
+	Acquisition_engine * Engine;
+	std::map<std::string, Acquisition_engine *>::iterator it;
+
+	registryMutex().lock();
+
+	it = registry().find(Name);
+	if (it == registry().end()) {
+		Engine = new Acquisition_engine(scheduler, priority, period,
+				cpu_affinity, Name);
+		registry()[Name] = Engine;
+	} else
+		Engine = it->second;
+
+	Engine->mutexBoards.lock();
+	Engine_boards * Boards = Engine->boards.prepare();
+	if (Boards->count >= ENGINE_MAX_BOARDS) {
+		Engine->mutexBoards.unlock();
+
+		//engine created just now is not used by anyone
+		if (Engine->users == 0) {
+			registry().erase(Name);
+			delete Engine;
+		}
+
+		registryMutex().unlock();
+		return NULL;
+	}
+	Engine->members[Boards->count] = Member;
+	Boards->boards[Boards->count++] = Board;
+	Engine->boards.publish(Boards);
+	Engine->mutexBoards.unlock();
+
+	++Engine->users;
+
+	if (!Engine->isRunning())
+		Engine->start();
+
+	registryMutex().unlock();
+
+	return Engine;
+}
+
+void Acquisition_engine::detach(Acquisition_engine * Engine,
+		Interface_thread * Board) {
+	if (Engine == NULL)
+		return;
+
+	Engine->mutexBoards.lock();
+	const Engine_boards * Old = Engine->boards.getPublished();
+	Engine_boards * Boards = Engine->boards.prepare();
+	for (int i = 0; i < Boards->count; ++i) {
+		if (Boards->boards[i] == Board) {
+			//order of the remaining boards is kept for the group frame
+			for (int j = i + 1; j < Boards->count; ++j) {
+				Boards->boards[j - 1] = Boards->boards[j];
+				Engine->members[j - 1] = Engine->members[j];
+			}
+			--Boards->count;
+			Boards->boards[Boards->count] = NULL;
+			Engine->members[Boards->count].clear();
+			break;
+		}
+	}
+	Engine->boards.publish(Boards);
+
+	//the running cycle may still use the board
+	while (Engine->boards.isUsed(Old))
+		usleep(100);
+	Engine->mutexBoards.unlock();
+
+	release(Engine);
+}
+
+Acquisition_engine * Acquisition_engine::find(std::string Name) {
+	Acquisition_engine * Engine = NULL;
+	std::map<std::string, Acquisition_engine *>::iterator it;
+
+	registryMutex().lock();
+
+	it = registry().find(Name);
+	if (it != registry().end()) {
+		Engine = it->second;
+		++Engine->users;
+	}
+
+	registryMutex().unlock();
+
+	return Engine;
+}
+
+void Acquisition_engine::release(Acquisition_engine * Engine) {
+	if (Engine == NULL)
+		return;
+
+	registryMutex().lock();
+
+	if (--Engine->users == 0) {
+		registry().erase(Engine->name);
+		delete Engine;
+	}
+
+	registryMutex().unlock();
+}
+
+void Acquisition_engine::step(void) {
+	RTT::os::TimeService * ts = RTT::os::TimeService::Instance();
+	long long Start = ts->getNSecs();
+	long long Period = getPeriodNS();
+	long long Timestamp;
+
+	//boards attached or detached meanwhile are taken in the next cycle
+	const Engine_boards * Boards = boards.acquire();
+	Interface_thread * const * Board = Boards->boards;
+	int Count = Boards->count;
+
+	++cycle;
+
+	for (int i = 0; i < Count; ++i)
+		Board[i]->startCycle(Start, Period);
+
+	//outputs and reconfiguration first, so they do not
+	//spread the reads apart
+	for (int i = 0; i < Count; ++i)
+		ready[i] = Board[i]->prepareCycle();
+
+	//all boards share the time of the cycle
+	Timestamp = ts->getNSecs();
+
+	for (int i = 0; i < Count; ++i)
+		if (ready[i])
+			Board[i]->readCycle(Timestamp);
+
+	//boards which could not be read publish stale frames
+	for (int i = 0; i < Count; ++i)
+		Board[i]->publishCycle(cycle);
+
+	acquired.seq = cycle;
+	acquired.timestamp = Timestamp;
+	acquired.boards = Count;
+
+	for (int i = 0; i < Count; ++i)
+		Board[i]->getFrame(acquired.frames[i]);
+
+	group.write(acquired);
+
+	triggering = 1;
+	__sync_synchronize();
+
+	RTT::base::ActivityInterface * Trigger = trigger;
+	if (Trigger)
+		Trigger->trigger();
+
+	__sync_synchronize();
+	triggering = 0;
+
+	long long End = ts->getNSecs();
+
+	for (int i = 0; i < Count; ++i)
+		Board[i]->finishCycle(Start, End, Period);
+
+	boards.release();
+}
+
+int Acquisition_engine::getBoards(void) {
+	int Count;
+
+	mutexBoards.lock();
+	Count = boards.getPublished()->count;
+	mutexBoards.unlock();
+
+	return Count;
+}
+
+std::vector<std::string> Acquisition_engine::getMembers(void) {
+	std::vector<std::string> Members;
+
+	mutexBoards.lock();
+	for (int i = 0; i < boards.getPublished()->count; ++i)
+		Members.push_back(members[i]);
+	mutexBoards.unlock();
+
+	return Members;
+}
+
+void Acquisition_engine::getGroupFrame(S626_group_frame & Frame) {
+	group.read(Frame);
+}
+
+void Acquisition_engine::setTrigger(RTT::base::ActivityInterface * Activity) {
+	trigger = Activity;
+
+	//the cycle may have loaded the previous activity already
+	__sync_synchronize();
+	while (triggering)
+		usleep(100);
+}
@@ -0,0 +1,211 @@
+/**
+ * \file Acquisition-engine.hpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef ACQUISITION_ENGINE_HPP
+#define ACQUISITION_ENGINE_HPP
+
+#include <string>
+#include <vector>
+
+#include <rtt/os/Mutex.hpp>
+#include <rtt/os/Thread.hpp>
+#include <rtt/base/ActivityInterface.hpp>
+
+#include "Aligned-alloc.hpp"
+#include "Interface-thread.hpp"
+#include "Seqlock.hpp"
+#include "Hazard-slots.hpp"
+#include "s626_task-types.hpp"
+
+/**
+ * Maximal number of boards serviced by a single engine
+ */
+#define ENGINE_MAX_BOARDS S626_GROUP_MAX_BOARDS
+
+/**
+ * Boards serviced in a cycle, never modified after it is published
+ */
+struct Engine_boards {
+	int count;
+
+	Interface_thread * boards[ENGINE_MAX_BOARDS];
+};
+
+/**
+ * \brief Acquisition_engine
+ *
+ * Real-time thread servicing several boards.
+ *
+ * In every cycle outputs of all the boards are written first,
+ * then their batched reads follow back to back and only
+ * after that the frames are published. The boards are
+ * sampled at close instants with a single context switch.
+ * All frames of a cycle share its timestamp and number,
+ * and they are published together as S626_group_frame.
+ *
+ * Engines are shared by name, every board attached with
+ * the same name is serviced by the same thread. Boards
+ * attached to an engine do not run their own thread.
+ */
+class Acquisition_engine: public RTT::os::Thread, public Aligned_alloc {
+public:
+
+	/**
+	 * \brief attach
+	 *
+	 * Adds the board to the engine of the given name. The engine is
+	 * created and started with the given thread settings when it does
+	 * not exist yet, otherwise the settings are ignored.
+	 *
+	 * \param[in]	Name				Name of the engine
+	 * \param[in]	Member			Name of the board reported by getMembers
+	 * \param[in]	Board				Board to be serviced
+	 *
+	 * \return		Engine servicing the board or NULL when it is full
+	 */
+	static Acquisition_engine * attach(std::string Name, std::string Member,
+			Interface_thread * Board, int scheduler, int priority, double period,
+			unsigned int cpu_affinity);
+
+	/**
+	 * \brief detach
+	 *
+	 * Removes the board from its engine. Returns when
+	 * the engine does not use the board any more.
+	 */
+	static void detach(Acquisition_engine * Engine, Interface_thread * Board);
+
+	/**
+	 * \brief find
+	 *
+	 * Takes reference to an existing engine without attaching a board.
+	 *
+	 * \return		Engine of the given name or NULL when there is none
+	 */
+	static Acquisition_engine * find(std::string Name);
+
+	/**
+	 * \brief release
+	 *
+	 * Drops reference taken by \link find find \endlink or
+	 * \link attach attach \endlink. The engine is stopped and
+	 * deleted with the last reference.
+	 */
+	static void release(Acquisition_engine * Engine);
+
+	void step(void);
+
+	/**
+	 * \brief getBoards
+	 *
+	 * \return		Number of boards serviced by the engine
+	 */
+	int getBoards(void);
+
+	/**
+	 * \brief getMembers
+	 *
+	 * \return		Names of the boards in the order of S626_group_frame
+	 */
+	std::vector<std::string> getMembers(void);
+
+	/**
+	 * \brief getGroupFrame
+	 *
+	 * Copies frames of all the boards read in the last cycle.
+	 * Never blocks the engine.
+	 */
+	void getGroupFrame(S626_group_frame & Frame);
+
+	/**
+	 * \brief setTrigger
+	 *
+	 * Returns only after a trigger of the previous activity which
+	 * is in progress has finished, so it is not triggered anymore.
+	 *
+	 * \param[in]	Activity		Activity triggered after every group
+	 * 											frame, NULL disables triggering
+	 */
+	void setTrigger(RTT::base::ActivityInterface * Activity);
+
+private:
+
+	Acquisition_engine(int scheduler, int priority, double period,
+			unsigned int cpu_affinity, std::string name);
+
+	~Acquisition_engine();
+
+	/**
+	 * Serializes changes of the boards and protects members,
+	 * never taken by the thread
+	 */
+	RTT::os::Mutex mutexBoards;
+
+	/**
+	 * Boards swapped in without locking the cycle
+	 */
+	Hazard_slots<Engine_boards> boards;
+
+	std::string members[ENGINE_MAX_BOARDS];
+
+	/**
+	 * Boards with a read in the current cycle
+	 */
+	bool ready[ENGINE_MAX_BOARDS];
+
+	/**
+	 * Number of references, protected by the registry mutex
+	 */
+	int users;
+
+	/**
+	 * Number of the current cycle
+	 */
+	unsigned int cycle;
+
+	/**
+	 * Group frame being assembled, owned by the thread
+	 */
+	S626_group_frame acquired;
+
+	/**
+	 * Last complete group frame published to readers
+	 */
+	Seqlock<S626_group_frame> group;
+
+	RTT::base::ActivityInterface * volatile trigger;
+
+	/**
+	 * Set while the engine triggers the consumer
+	 */
+	volatile int triggering;
+
+	std::string name;
+};
+
+#endif
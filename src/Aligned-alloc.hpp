@@ -0,0 +1,66 @@
+/**
+ * \file Aligned-alloc.hpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef ALIGNED_ALLOC_HPP
+#define ALIGNED_ALLOC_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/**
+ * Alignment of objects derived from Aligned_alloc, one cache line
+ */
+#define ALIGNED_ALLOC_ALIGNMENT 64
+
+/**
+ * \brief Aligned_alloc
+ *
+ * Base of classes with cache line aligned members which are
+ * created on the heap. Plain new only guarantees alignment
+ * of fundamental types, so the members could share a cache
+ * line with unrelated data.
+ */
+class Aligned_alloc {
+public:
+
+	static void * operator new(size_t size) {
+		void * ptr;
+
+		if (posix_memalign(&ptr, ALIGNED_ALLOC_ALIGNMENT, size) != 0)
+			throw std::bad_alloc();
+
+		return ptr;
+	}
+
+	static void operator delete(void * ptr) {
+		free(ptr);
+	}
+
+};
+
+#endif
@@ -0,0 +1,219 @@
+/**
+ * \file Analogy-backend.cpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "Analogy-backend.hpp"
+
+#include <errno.h>
+
+Analogy_backend::Analogy_backend() :
+		s626(NULL), adcRange(0) {
+}
+
+Analogy_backend::~Analogy_backend() {
+	close();
+}
+
+int Analogy_backend::open(std::string Device, int Bus, int Slot) {
+	int err;
+
+	s626 = s626_init("S626", Device.c_str());
+
+	err = s626_set_options(s626);
+	if (err < 0) {
+		s626_deinit(s626);
+		s626 = NULL;
+		return -2;
+	}
+
+	err = s626_set_bus(s626, Bus);
+	if (err < 0) {
+		s626_deinit(s626);
+		s626 = NULL;
+		return -3;
+	}
+
+	err = s626_set_slot(s626, Slot);
+	if (err < 0) {
+		s626_deinit(s626);
+		s626 = NULL;
+		return -4;
+	}
+
+	err = s626_open(s626);
+	if (err < 0) {
+		s626_deinit(s626);
+		s626 = NULL;
+		return -5;
+	}
+
+	s626_adc_set_range(s626, 0xFFFF, adcRange);
+
+	err = configureFrame(frameADC, frameENC, frameDIO);
+	if (err < 0) {
+		close();
+		return -5;
+	}
+
+	return 0;
+}
+
+int Analogy_backend::close(void) {
+	int err;
+
+	if (s626) {
+		err = s626_close(s626);
+
+		if (err < 0)
+			return err;
+
+		s626_deinit(s626);
+
+		s626 = NULL;
+	}
+
+	return 0;
+}
+
+bool Analogy_backend::isOpen(void) {
+	return s626 != NULL;
+}
+
+int Analogy_backend::readDIO(int bank, int * value) {
+	if (bank >= (int) s626->desc.dio_banks)
+		return -ENODEV;
+
+	return s626_dio_read(s626, s626->desc.dio_subd + bank, 0, value);
+}
+
+int Analogy_backend::writeDIO(int bank, int mask, int value) {
+	if (bank >= (int) s626->desc.dio_banks)
+		return -ENODEV;
+
+	return s626_dio_write(s626, s626->desc.dio_subd + bank, mask, value);
+}
+
+int Analogy_backend::readADC(int channel, int * value) {
+	int err;
+	short int Data = 0;
+
+	if (s626->desc.adc_subd < 0)
+		return -ENODEV;
+
+	err = s626_adc_read(s626, s626->desc.adc_subd, channel, (char *) (&Data),
+			1);
+
+	*value = Data & 0x3FFF;
+
+	return err;
+}
+
+void Analogy_backend::setrangeADC(int mask, int value) {
+	adcRange = (adcRange & ~mask) | (value & mask);
+
+	if (s626)
+		s626_adc_set_range(s626, mask, value);
+}
+
+int Analogy_backend::writeDAC(int channel, int value) {
+	char buffer[2];
+
+	*(short int *) (&buffer[0]) = (short int) (value & 0xFFFF);
+
+	if (s626->desc.dac_subd < 0)
+		return -ENODEV;
+
+	return s626_dac_write(s626, s626->desc.dac_subd, channel, &buffer[0]);
+}
+
+int Analogy_backend::configureENC(int channel) {
+	if (s626->desc.enc_subd < 0)
+		return -ENODEV;
+
+	return s626_gpct_conf_enc(s626, s626->desc.enc_subd, channel);
+}
+
+int Analogy_backend::readENC(int channel, int * value) {
+	if (s626->desc.enc_subd < 0)
+		return -ENODEV;
+
+	return s626_gpct_read_enc(s626, s626->desc.enc_subd, channel, value);
+}
+
+int Analogy_backend::configureFrame(int ADCMask, int ENCMask, int DIOMask) {
+	Board_backend::configureFrame(ADCMask, ENCMask, DIOMask);
+
+	if (s626 == NULL)
+		return -1;
+
+	//subdevices missing on the board leave their channels out
+	return s626_frame_configure(s626, s626->desc.adc_subd, s626->desc.enc_subd,
+			s626->desc.dio_subd, ADCMask, ENCMask, DIOMask);
+}
+
+int Analogy_backend::readFrame(int ADCMask, int ENCMask, int DIOMask,
+		int * ADC, int * ENC, int * DIO) {
+	return s626_frame_read(s626, ADCMask, ENCMask, DIOMask, ADC, ENC, DIO);
+}
+
+int Analogy_backend::writeOutputs(int DACMask, const int * DAC, int DIOMask,
+		const int * DIOMasks, const int * DIOValues) {
+	if ((DACMask && s626->desc.dac_subd < 0)
+			|| (DIOMask >> s626->desc.dio_banks) != 0)
+		return -ENODEV;
+
+	return s626_write_outputs(s626, s626->desc.dac_subd, s626->desc.dio_subd,
+			DACMask, DAC, DIOMask, DIOMasks, DIOValues);
+}
+
+int Analogy_backend::startADCScan(int Mask, int Period) {
+	scanADC = Mask;
+
+	if (s626 == NULL)
+		return -1;
+
+	if (s626->desc.adc_subd < 0)
+		return -ENODEV;
+
+	return s626_adc_scan_start(s626, s626->desc.adc_subd, Mask, Period);
+}
+
+int Analogy_backend::readADCScan(int * ADC) {
+	return s626_adc_scan_read(s626, ADC);
+}
+
+int Analogy_backend::stopADCScan(void) {
+	scanADC = 0;
+
+	if (s626 == NULL)
+		return 0;
+
+	return s626_adc_scan_stop(s626);
+}
+
+std::string Analogy_backend::getName(void) {
+	return "analogy";
+}
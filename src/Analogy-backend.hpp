@@ -0,0 +1,112 @@
+/**
+ * \file Analogy-backend.hpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef ANALOGY_BACKEND_HPP
+#define ANALOGY_BACKEND_HPP
+
+#include "Board-backend.hpp"
+
+#include "S626API.h"
+
+/**
+ * \brief Analogy_backend
+ *
+ * Backend talking to the real Sensoray 626 board
+ * through the Xenomai Analogy driver (S626API).
+ */
+class Analogy_backend: public Board_backend {
+public:
+
+	Analogy_backend();
+
+	~Analogy_backend();
+
+	int open(std::string Device, int Bus, int Slot);
+
+	int close(void);
+
+	bool isOpen(void);
+
+	int readDIO(int bank, int * value);
+
+	int writeDIO(int bank, int mask, int value);
+
+	int readADC(int channel, int * value);
+
+	void setrangeADC(int mask, int value);
+
+	int writeDAC(int channel, int value);
+
+	int configureENC(int channel);
+
+	int readENC(int channel, int * value);
+
+	/**
+	 * Prebuilds Analogy instruction list covering
+	 * all the selected channels
+	 */
+	int configureFrame(int ADCMask, int ENCMask, int DIOMask);
+
+	/**
+	 * Submits the prebuilt instruction list, or its subset,
+	 * with single ioctl
+	 */
+	int readFrame(int ADCMask, int ENCMask, int DIOMask, int * ADC, int * ENC,
+			int * DIO);
+
+	/**
+	 * Writes all the outputs with a single instruction list
+	 */
+	int writeOutputs(int DACMask, const int * DAC, int DIOMask,
+			const int * DIOMasks, const int * DIOValues);
+
+	/**
+	 * Programs the poll list and starts asynchronous
+	 * Analogy command, the buffer is mapped with a4l_mmap
+	 */
+	int startADCScan(int Mask, int Period);
+
+	/**
+	 * Consumes the latest scan in place from the mapped buffer
+	 */
+	int readADCScan(int * ADC);
+
+	int stopADCScan(void);
+
+	std::string getName(void);
+
+private:
+
+	ts626 * s626;
+
+	/**
+	 * ADC range kept while the board is closed
+	 */
+	int adcRange;
+
+};
+#endif
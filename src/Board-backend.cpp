@@ -0,0 +1,145 @@
+/**
+ * \file Board-backend.cpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "Board-backend.hpp"
+
+#include "Sim-backend.hpp"
+#include "Replay-backend.hpp"
+
+#ifndef S626_NO_ANALOGY
+#include "Analogy-backend.hpp"
+#endif
+
+int Board_backend::configureFrame(int ADCMask, int ENCMask, int DIOMask) {
+	frameADC = ADCMask;
+	frameENC = ENCMask;
+	frameDIO = DIOMask;
+
+	return 0;
+}
+
+int Board_backend::readFrame(int ADCMask, int ENCMask, int DIOMask, int * ADC,
+		int * ENC, int * DIO) {
+	int err;
+
+	ADCMask &= frameADC;
+	ENCMask &= frameENC;
+	DIOMask &= frameDIO;
+
+	for (int i = 0; i < BOARD_DIO_BANKS; ++i) {
+		if (DIOMask & (1 << i)) {
+			err = readDIO(i, &DIO[i]);
+			if (err < 0)
+				return err;
+		}
+	}
+
+	for (int i = 0; i < BOARD_ENC_CHANNELS; ++i) {
+		if (ENCMask & (1 << i)) {
+			err = readENC(i, &ENC[i]);
+			if (err < 0)
+				return err;
+		}
+	}
+
+	for (int i = 0; i < BOARD_ADC_CHANNELS; ++i) {
+		if (ADCMask & (1 << i)) {
+			err = readADC(i, &ADC[i]);
+			if (err < 0)
+				return err;
+		}
+	}
+
+	return 0;
+}
+
+int Board_backend::writeOutputs(int DACMask, const int * DAC, int DIOMask,
+		const int * DIOMasks, const int * DIOValues) {
+	int err;
+
+	for (int i = 0; i < BOARD_DAC_CHANNELS; ++i) {
+		if (DACMask & (1 << i)) {
+			err = writeDAC(i, DAC[i]);
+			if (err < 0)
+				return err;
+		}
+	}
+
+	for (int i = 0; i < BOARD_DIO_BANKS; ++i) {
+		if (DIOMask & (1 << i)) {
+			err = writeDIO(i, DIOMasks[i], DIOValues[i]);
+			if (err < 0)
+				return err;
+		}
+	}
+
+	return 0;
+}
+
+int Board_backend::startADCScan(int Mask, int /* Period */) {
+	scanADC = Mask;
+
+	return 0;
+}
+
+int Board_backend::readADCScan(int * ADC) {
+	int err;
+
+	if (scanADC == 0)
+		return 0;
+
+	for (int i = 0; i < BOARD_ADC_CHANNELS; ++i) {
+		if (scanADC & (1 << i)) {
+			err = readADC(i, &ADC[i]);
+			if (err < 0)
+				return err;
+		}
+	}
+
+	return 1;
+}
+
+int Board_backend::stopADCScan(void) {
+	scanADC = 0;
+
+	return 0;
+}
+
+Board_backend * createBoardBackend(std::string Name) {
+	if (Name == "sim")
+		return new Sim_backend();
+
+	if (Name == "replay")
+		return new Replay_backend();
+
+#ifndef S626_NO_ANALOGY
+	if (Name == "analogy")
+		return new Analogy_backend();
+#endif
+
+	return NULL;
+}
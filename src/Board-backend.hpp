@@ -0,0 +1,223 @@
+/**
+ * \file Board-backend.hpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef BOARD_BACKEND_HPP
+#define BOARD_BACKEND_HPP
+
+#include <string>
+
+#define BOARD_ADC_CHANNELS 16
+#define BOARD_DAC_CHANNELS 4
+#define BOARD_ENC_CHANNELS 6
+#define BOARD_DIO_BANKS 3
+
+#define BOARD_PERIPHERAL_ADC 0
+#define BOARD_PERIPHERAL_DAC 1
+#define BOARD_PERIPHERAL_ENC 2
+#define BOARD_PERIPHERAL_DIO 3
+#define BOARD_PERIPHERALS 4
+
+/**
+ * \brief Board_backend
+ *
+ * Interface between Interface_thread and a Sensoray 626 board.
+ *
+ * Every call is made with the card mutex of the owning
+ * Interface_thread held, so implementations do not need
+ * to be thread safe on their own.
+ * All the functions returning int return 0 on success
+ * and negative error code otherwise.
+ */
+class Board_backend {
+public:
+
+	Board_backend() :
+			frameADC(0), frameENC(0), frameDIO(0), scanADC(0) {
+	}
+
+	virtual ~Board_backend() {
+	}
+
+	/**
+	 * \brief open
+	 *
+	 * Attaches and opens the board.
+	 *
+	 * \param[in]	Device		Name of analogy device ex. analogy0, analogy1, ...
+	 * \param[in] Bus				Bus number on which s626 is physically available
+	 * \param[in] Slot			Slot number on which s626 is physically available
+	 *
+	 * \return		0					Board is ready to use
+	 * 					-2					Options could not be set
+	 * 					-3					Bus could not be set
+	 * 					-4					Slot could not be set
+	 * 					-5					Device could not be opened
+	 */
+	virtual int open(std::string Device, int Bus, int Slot) = 0;
+
+	virtual int close(void) = 0;
+
+	virtual bool isOpen(void) = 0;
+
+	virtual int readDIO(int bank, int * value) = 0;
+
+	virtual int writeDIO(int bank, int mask, int value) = 0;
+
+	/**
+	 * \brief readADC
+	 *
+	 * Converts a single ADC channel.
+	 *
+	 * \param[in]		channel		Channel 0-15
+	 * \param[out]	value			Raw value in range from 0 to 2^14 - 1
+	 */
+	virtual int readADC(int channel, int * value) = 0;
+
+	virtual void setrangeADC(int mask, int value) = 0;
+
+	virtual int writeDAC(int channel, int value) = 0;
+
+	virtual int configureENC(int channel) = 0;
+
+	virtual int readENC(int channel, int * value) = 0;
+
+	/**
+	 * \brief configureFrame
+	 *
+	 * Selects channels read by \link readFrame readFrame \endlink.
+	 * Called only when the selection changes.
+	 *
+	 * \param[in]	ADCMask		ADC channel selector
+	 * \param[in]	ENCMask		ENC channel selector
+	 * \param[in]	DIOMask		DIO bank selector
+	 */
+	virtual int configureFrame(int ADCMask, int ENCMask, int DIOMask);
+
+	/**
+	 * \brief readFrame
+	 *
+	 * Reads channels selected by the masks, which have to be
+	 * a subset of channels passed to \link configureFrame
+	 * configureFrame \endlink. Only the read entries of
+	 * the arrays are written.
+	 *
+	 * Default implementation reads channel by channel,
+	 * backends should override it with a batched read.
+	 */
+	virtual int readFrame(int ADCMask, int ENCMask, int DIOMask, int * ADC,
+			int * ENC, int * DIO);
+
+	/**
+	 * \brief writeOutputs
+	 *
+	 * Writes the selected DAC channels and DIO banks at once.
+	 *
+	 * Default implementation writes channel by channel,
+	 * backends should override it with a batched write.
+	 *
+	 * \param[in]	DACMask			DAC channel selector
+	 * \param[in]	DAC					Values of DAC channels
+	 * \param[in]	DIOMask			DIO bank selector
+	 * \param[in]	DIOMasks		Mask of outputs of each bank
+	 * \param[in]	DIOValues		Value of each bank
+	 */
+	virtual int writeOutputs(int DACMask, const int * DAC, int DIOMask,
+			const int * DIOMasks, const int * DIOValues);
+
+	/**
+	 * \brief startADCScan
+	 *
+	 * Starts hardware timed acquisition of the selected ADC channels.
+	 *
+	 * \param[in]	Mask			ADC channel selector
+	 * \param[in]	Period		Time between consecutive scans in nanoseconds
+	 */
+	virtual int startADCScan(int Mask, int Period);
+
+	/**
+	 * \brief readADCScan
+	 *
+	 * Takes the latest complete scan. Only the scanned
+	 * channels of the array are written.
+	 *
+	 * Default implementation converts the channels
+	 * synchronously, once per call.
+	 *
+	 * \return		Number of complete scans since the last call
+	 * 						or negative error code
+	 */
+	virtual int readADCScan(int * ADC);
+
+	virtual int stopADCScan(void);
+
+	/**
+	 * \brief hasBacklog
+	 *
+	 * Tells whether another frame can be read right away, without
+	 * waiting for the hardware. The interface thread then reads it
+	 * in the same period.
+	 *
+	 * \return		false by default
+	 */
+	virtual bool hasBacklog(void) {
+		return false;
+	}
+
+	/**
+	 * \brief getName
+	 *
+	 * \return		Name of the backend as accepted by \link createBoardBackend
+	 * 						createBoardBackend \endlink
+	 */
+	virtual std::string getName(void) = 0;
+
+protected:
+
+	int frameADC;
+
+	int frameENC;
+
+	int frameDIO;
+
+	int scanADC;
+};
+
+/**
+ * \brief createBoardBackend
+ *
+ * Creates backend by its name.
+ *
+ * \param[in]	Name		"analogy" for the Xenomai Analogy driver,
+ * 										"sim" for the in-process simulated board or
+ * 										"replay" for a recorded session
+ *
+ * \return		New backend or NULL when the name is not known
+ * 						or the backend was not compiled in
+ */
+Board_backend * createBoardBackend(std::string Name);
+
+#endif
@@ -0,0 +1,104 @@
+/**
+ * \file Channel-table.hpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef CHANNEL_TABLE_HPP
+#define CHANNEL_TABLE_HPP
+
+#include "Board-backend.hpp"
+#include "Hazard-slots.hpp"
+
+/**
+ * Dense list of the enabled channels of a peripheral
+ */
+struct Channel_list {
+	/**
+	 * Number of the enabled channels
+	 */
+	int count;
+
+	/**
+	 * Bit mask of the enabled channels
+	 */
+	int mask;
+
+	int channel[BOARD_ADC_CHANNELS];
+
+	int divider[BOARD_ADC_CHANNELS];
+
+	int phase[BOARD_ADC_CHANNELS];
+};
+
+/**
+ * \brief Channel_table
+ *
+ * Channel configuration compiled for the acquisition loop.
+ * Never modified after it is published.
+ */
+struct Channel_table {
+	Channel_list ADC;
+
+	Channel_list ENC;
+
+	Channel_list DIO;
+
+	/**
+	 * ADC channels scanned by the board instead of
+	 * being converted in the frame
+	 */
+	int scanADC;
+
+	/**
+	 * Hardware scan period in nanoseconds
+	 */
+	int scanPeriod;
+
+	/**
+	 * Range of all ADC channels as accepted by
+	 * Board_backend::setrangeADC
+	 */
+	int rangeADC;
+
+	/**
+	 * Output masks of DIO banks
+	 */
+	int outputDIO[BOARD_DIO_BANKS];
+
+	/**
+	 * Incremented with every compiled table
+	 */
+	unsigned int generation;
+};
+
+/**
+ * \brief Channel_tables
+ *
+ * Publishes channel tables to the acquisition loop without locks.
+ */
+typedef Hazard_slots<Channel_table> Channel_tables;
+
+#endif
@@ -0,0 +1,149 @@
+/**
+ * \file Cycle-stats.cpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "Cycle-stats.hpp"
+
+Cycle_histogram::Cycle_histogram() :
+		resetRequest(1) {
+	for (int i = 0; i < CYCLE_HISTOGRAM_BUCKETS; ++i)
+		counts[i] = 0;
+
+	count = 0;
+	min = 0;
+	max = 0;
+	sum = 0;
+}
+
+int Cycle_histogram::bucket(long long Value) {
+	int Msb, Bucket;
+
+	if (Value < 4)
+		return Value < 0 ? 0 : (int) Value;
+
+	Msb = 63 - __builtin_clzll((unsigned long long) Value);
+
+	//two bits after the most significant one select the bucket
+	Bucket = 4 * (Msb - 1) + (int) ((Value >> (Msb - 2)) & 3);
+
+	if (Bucket >= CYCLE_HISTOGRAM_BUCKETS)
+		Bucket = CYCLE_HISTOGRAM_BUCKETS - 1;
+
+	return Bucket;
+}
+
+long long Cycle_histogram::bound(int Bucket) {
+	int Msb;
+
+	if (Bucket < 4)
+		return Bucket;
+
+	Msb = Bucket / 4 + 1;
+
+	return ((long long) (4 + Bucket % 4) << (Msb - 2))
+			+ ((long long) 1 << (Msb - 2)) - 1;
+}
+
+void Cycle_histogram::record(long long Value) {
+	if (resetRequest) {
+		for (int i = 0; i < CYCLE_HISTOGRAM_BUCKETS; ++i)
+			counts[i] = 0;
+
+		count = 0;
+		sum = 0;
+		resetRequest = 0;
+	}
+
+	if (count == 0) {
+		min = Value;
+		max = Value;
+	} else if (Value < min)
+		min = Value;
+	else if (Value > max)
+		max = Value;
+
+	++counts[bucket(Value)];
+	sum += Value;
+
+	__sync_synchronize();
+	++count;
+}
+
+void Cycle_histogram::reset(void) {
+	resetRequest = 1;
+}
+
+long long Cycle_histogram::percentile(const unsigned int * Counts,
+		unsigned int Count, double Percentile) const {
+	unsigned long long Rank, Cumulative = 0;
+
+	if (Count == 0)
+		return 0;
+
+	Rank = (unsigned long long) (Percentile / 100.0 * Count);
+	if (Rank >= Count)
+		Rank = Count - 1;
+
+	for (int i = 0; i < CYCLE_HISTOGRAM_BUCKETS; ++i) {
+		Cumulative += Counts[i];
+
+		if (Cumulative > Rank)
+			return bound(i) < max ? bound(i) : max;
+	}
+
+	return max;
+}
+
+long long Cycle_histogram::percentile(double Percentile) const {
+	unsigned int Counts[CYCLE_HISTOGRAM_BUCKETS];
+	unsigned int Count = 0;
+
+	for (int i = 0; i < CYCLE_HISTOGRAM_BUCKETS; ++i) {
+		Counts[i] = counts[i];
+		Count += Counts[i];
+	}
+
+	return percentile(Counts, Count, Percentile);
+}
+
+void Cycle_histogram::summary(S626_timing & Timing) const {
+	unsigned int Counts[CYCLE_HISTOGRAM_BUCKETS];
+	unsigned int Count = 0;
+
+	for (int i = 0; i < CYCLE_HISTOGRAM_BUCKETS; ++i) {
+		Counts[i] = counts[i];
+		Count += Counts[i];
+	}
+
+	Timing.count = Count;
+	Timing.min = Count ? min : 0;
+	Timing.max = Count ? max : 0;
+	Timing.mean = Count ? sum / Count : 0;
+	Timing.p50 = percentile(Counts, Count, 50.0);
+	Timing.p90 = percentile(Counts, Count, 90.0);
+	Timing.p99 = percentile(Counts, Count, 99.0);
+	Timing.p999 = percentile(Counts, Count, 99.9);
+}
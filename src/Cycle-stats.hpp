@@ -0,0 +1,111 @@
+/**
+ * \file Cycle-stats.hpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef CYCLE_STATS_HPP
+#define CYCLE_STATS_HPP
+
+#include "s626_task-types.hpp"
+
+/**
+ * Number of buckets, 4 buckets for each power of two
+ * which covers values up to about 2^40 ns
+ */
+#define CYCLE_HISTOGRAM_BUCKETS 160
+
+/**
+ * \brief Cycle_histogram
+ *
+ * Log scale histogram of durations in nanoseconds.
+ *
+ * Every power of two is split into 4 buckets, so the
+ * relative error of a percentile is below 25%.
+ * Only one thread may record, any thread may read.
+ * Recording is constant time and does not lock,
+ * readers may see a histogram which is one sample
+ * behind in some buckets.
+ */
+class Cycle_histogram {
+public:
+
+	Cycle_histogram();
+
+	/**
+	 * \brief record
+	 *
+	 * Adds a sample. Called only by the owning thread.
+	 */
+	void record(long long Value);
+
+	/**
+	 * \brief reset
+	 *
+	 * Requests clearing of the histogram. It is
+	 * performed by the recording thread before its next
+	 * sample, so it is safe to call from any thread.
+	 */
+	void reset(void);
+
+	/**
+	 * \brief summary
+	 *
+	 * Computes min, max, mean and percentiles.
+	 */
+	void summary(S626_timing & Timing) const;
+
+	/**
+	 * \brief percentile
+	 *
+	 * \param[in]	Percentile		Value from 0 to 100
+	 *
+	 * \return		Upper bound of the bucket holding the percentile
+	 */
+	long long percentile(double Percentile) const;
+
+private:
+
+	static int bucket(long long Value);
+
+	static long long bound(int Bucket);
+
+	long long percentile(const unsigned int * Counts, unsigned int Count,
+			double Percentile) const;
+
+	volatile unsigned int counts[CYCLE_HISTOGRAM_BUCKETS];
+
+	volatile unsigned int count;
+
+	volatile long long min;
+
+	volatile long long max;
+
+	volatile long long sum;
+
+	volatile int resetRequest;
+
+};
+
+#endif
@@ -0,0 +1,204 @@
+/**
+ * \file Diag-log.cpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include "Diag-log.hpp"
+
+#include <cstring>
+
+#include <rtt/Logger.hpp>
+#include <rtt/os/TimeService.hpp>
+
+Diag_log::Diag_log(double period, std::string name) :
+		Thread(ORO_SCHED_OTHER, 0, period, ~0u, name), head(0), tail(0), lastError(
+				0), lost(0), reported(0) {
+	//N has to be a power of two, indexes wrap around
+	typedef char PowerOfTwo[(DIAG_LOG_SIZE & (DIAG_LOG_SIZE - 1)) == 0 ? 1 : -1];
+	(void) sizeof(PowerOfTwo);
+
+	for (unsigned int i = 0; i < DIAG_LOG_SIZE; ++i)
+		slots[i].sequence = i;
+
+	for (int i = 0; i < DIAG_PERIPHERALS; ++i)
+		for (int j = 0; j < DIAG_CHANNELS; ++j)
+			errors[i][j] = 0;
+}
+
+Diag_log::~Diag_log() {
+	stop();
+
+	flush();
+}
+
+void Diag_log::report(int Code, int Peripheral, int Channel, int Error) {
+	unsigned int Position;
+	Slot * Entry;
+
+	if (Peripheral < 0 || Peripheral >= DIAG_PERIPHERALS)
+		Peripheral = DIAG_PERIPHERAL_BOARD;
+
+	__sync_fetch_and_add(
+			&errors[Peripheral][
+					Channel >= 0 && Channel < DIAG_CHANNELS - 1 ?
+							Channel : DIAG_CHANNELS - 1], 1);
+	__sync_lock_test_and_set(&lastError, Error);
+
+	//producers claim slots which the consumer released
+	Position = head;
+	for (;;) {
+		Entry = &slots[Position & (DIAG_LOG_SIZE - 1)];
+		int Difference = (int) (Entry->sequence - Position);
+
+		if (Difference == 0) {
+			if (__sync_bool_compare_and_swap(&head, Position, Position + 1))
+				break;
+			Position = head;
+		} else if (Difference < 0) {
+			__sync_fetch_and_add(&lost, 1);
+			return;
+		} else
+			Position = head;
+	}
+
+	Entry->record.timestamp = RTT::os::TimeService::Instance()->getNSecs();
+	Entry->record.code = Code;
+	Entry->record.peripheral = Peripheral;
+	Entry->record.channel = Channel;
+	Entry->record.error = Error;
+
+	//record is complete before the consumer sees it
+	__sync_synchronize();
+	Entry->sequence = Position + 1;
+}
+
+bool Diag_log::pop(Diag_record & Record) {
+	Slot * Entry = &slots[tail & (DIAG_LOG_SIZE - 1)];
+
+	if ((int) (Entry->sequence - (tail + 1)) < 0)
+		return false;
+
+	__sync_synchronize();
+	Record = Entry->record;
+
+	//record is read before the slot is released
+	__sync_synchronize();
+	Entry->sequence = tail + DIAG_LOG_SIZE;
+	++tail;
+
+	return true;
+}
+
+unsigned int Diag_log::getErrors(int Peripheral, int Channel) {
+	unsigned int Sum = 0;
+
+	if (Peripheral < 0 || Peripheral >= DIAG_PERIPHERALS)
+		return 0;
+
+	if (Channel >= 0)
+		return Channel < DIAG_CHANNELS - 1 ? errors[Peripheral][Channel] : 0;
+
+	for (int i = 0; i < DIAG_CHANNELS; ++i)
+		Sum += errors[Peripheral][i];
+
+	return Sum;
+}
+
+int Diag_log::getLastError(void) {
+	return __sync_lock_test_and_set(&lastError, 0);
+}
+
+void Diag_log::resetErrors(void) {
+	for (int i = 0; i < DIAG_PERIPHERALS; ++i)
+		for (int j = 0; j < DIAG_CHANNELS; ++j)
+			__sync_lock_test_and_set(&errors[i][j], 0);
+
+	__sync_lock_test_and_set(&lastError, 0);
+}
+
+unsigned int Diag_log::getLost(void) {
+	return lost;
+}
+
+void Diag_log::flush(void) {
+	static const char * Peripherals[DIAG_PERIPHERALS] = { "ADC", "DAC", "ENC",
+			"DIO", "board" };
+	Diag_record Record;
+	unsigned int Lost;
+
+	mutexFlush.lock();
+
+	while (pop(Record)) {
+		RTT::log(RTT::Logger::Error) << getName() << ": "
+				<< describe(Record.code) << " failed, " << Peripherals[Record.peripheral];
+		if (Record.channel >= 0)
+			RTT::log() << " channel " << Record.channel;
+		RTT::log() << ", error " << Record.error << " (" << strerror(-Record.error)
+				<< ") at " << Record.timestamp << RTT::endlog();
+	}
+
+	Lost = lost;
+	if (Lost != reported) {
+		RTT::log(RTT::Logger::Warning) << getName() << ": " << Lost - reported
+				<< " error records lost" << RTT::endlog();
+		reported = Lost;
+	}
+
+	mutexFlush.unlock();
+}
+
+const char * Diag_log::describe(int Code) {
+	switch (Code) {
+	case DIAG_CODE_CONFIGURE_FRAME:
+		return "frame configuration";
+	case DIAG_CODE_START_SCAN:
+		return "ADC scan start";
+	case DIAG_CODE_READ_FRAME:
+		return "frame read";
+	case DIAG_CODE_READ_SCAN:
+		return "ADC scan read";
+	case DIAG_CODE_WRITE_OUTPUTS:
+		return "output write";
+	case DIAG_CODE_CONFIGURE_ENC:
+		return "encoder configuration";
+	case DIAG_CODE_OPEN:
+		return "board open";
+	case DIAG_CODE_CLOSE:
+		return "board close";
+	case DIAG_CODE_NOT_OPEN:
+		return "access to closed board";
+	default:
+		return "unknown operation";
+	}
+}
+
+void Diag_log::step(void) {
+	flush();
+}
+
+void Diag_log::finalize(void) {
+	flush();
+}
@@ -0,0 +1,208 @@
+/**
+ * \file Diag-log.hpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef DIAG_LOG_HPP
+#define DIAG_LOG_HPP
+
+#include <string>
+
+#include <rtt/os/Mutex.hpp>
+#include <rtt/os/Thread.hpp>
+
+#include "Aligned-alloc.hpp"
+#include "Board-backend.hpp"
+
+/**
+ * Number of records buffered until the logging thread runs,
+ * has to be a power of two
+ */
+#define DIAG_LOG_SIZE 256
+
+/**
+ * Operations on the whole board, next to BOARD_PERIPHERAL_*
+ */
+#define DIAG_PERIPHERAL_BOARD BOARD_PERIPHERALS
+#define DIAG_PERIPHERALS (BOARD_PERIPHERALS + 1)
+
+/**
+ * Counters of each peripheral, the last one for
+ * errors not tied to a channel
+ */
+#define DIAG_CHANNELS (BOARD_ADC_CHANNELS + 1)
+
+#define DIAG_CODE_CONFIGURE_FRAME 1
+#define DIAG_CODE_START_SCAN 2
+#define DIAG_CODE_READ_FRAME 3
+#define DIAG_CODE_READ_SCAN 4
+#define DIAG_CODE_WRITE_OUTPUTS 5
+#define DIAG_CODE_CONFIGURE_ENC 6
+#define DIAG_CODE_OPEN 7
+#define DIAG_CODE_CLOSE 8
+#define DIAG_CODE_NOT_OPEN 9
+
+/**
+ * \brief Diag_record
+ *
+ * Single failure reported by the acquisition.
+ */
+struct Diag_record {
+	long long timestamp;
+
+	/**
+	 * What failed, DIAG_CODE_*
+	 */
+	int code;
+
+	/**
+	 * BOARD_PERIPHERAL_* or DIAG_PERIPHERAL_BOARD
+	 */
+	int peripheral;
+
+	/**
+	 * Channel or bank, -1 when not tied to a channel
+	 */
+	int channel;
+
+	/**
+	 * Negative error code returned by the backend, usually -errno
+	 */
+	int error;
+};
+
+/**
+ * \brief Diag_log
+ *
+ * Error reporting usable from the real-time thread.
+ *
+ * \link report report \endlink counts the error and puts a record
+ * into a preallocated lock-free ring without blocking, allocating
+ * or printing. A low priority thread writes the records to the
+ * RTT logger. Records which do not fit into the ring are counted
+ * as lost, counters are kept for all errors.
+ */
+class Diag_log: public RTT::os::Thread, public Aligned_alloc {
+public:
+
+	/**
+	 * \param[in]	period		Period of the logging thread in seconds
+	 */
+	Diag_log(double period, std::string name);
+
+	~Diag_log();
+
+	/**
+	 * \brief report
+	 *
+	 * Records a failure. May be called by any thread,
+	 * never blocks.
+	 */
+	void report(int Code, int Peripheral, int Channel, int Error);
+
+	/**
+	 * \brief getErrors
+	 *
+	 * \param[in]	Peripheral	BOARD_PERIPHERAL_* or DIAG_PERIPHERAL_BOARD
+	 * \param[in]	Channel			Channel or bank, -1 for all the errors
+	 * 												of the peripheral
+	 *
+	 * \return		Number of errors since the last reset
+	 */
+	unsigned int getErrors(int Peripheral, int Channel);
+
+	/**
+	 * \brief getLastError
+	 *
+	 * \return		Error code of the last failure, 0 when there was
+	 * 						none since the previous call
+	 */
+	int getLastError(void);
+
+	void resetErrors(void);
+
+	/**
+	 * \return		Number of records not logged because the ring was full
+	 */
+	unsigned int getLost(void);
+
+	/**
+	 * \brief flush
+	 *
+	 * Writes all buffered records to the RTT logger.
+	 * Called by the logging thread, or directly when it is stopped.
+	 */
+	void flush(void);
+
+	/**
+	 * \return		Description of DIAG_CODE_*
+	 */
+	static const char * describe(int Code);
+
+	void step(void);
+
+	void finalize(void);
+
+private:
+
+	/**
+	 * Slot of the ring, sequence tells producers and the consumer
+	 * whether the slot is free or holds a record
+	 */
+	struct Slot {
+		volatile unsigned int sequence;
+		Diag_record record;
+	};
+
+	/**
+	 * Takes the oldest record, called with mutexFlush held
+	 */
+	bool pop(Diag_record & Record);
+
+	volatile unsigned int head __attribute__ ((aligned (64)));
+
+	unsigned int tail __attribute__ ((aligned (64)));
+
+	Slot slots[DIAG_LOG_SIZE];
+
+	volatile unsigned int errors[DIAG_PERIPHERALS][DIAG_CHANNELS];
+
+	volatile int lastError;
+
+	volatile unsigned int lost;
+
+	/**
+	 * Lost records already logged
+	 */
+	unsigned int reported;
+
+	/**
+	 * Serializes consumers of the ring
+	 */
+	RTT::os::Mutex mutexFlush;
+};
+
+#endif
@@ -0,0 +1,217 @@
+/**
+ * \file Driver-manager.cpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "Driver-manager.hpp"
+
+#include <rtt/os/TimeService.hpp>
+
+Driver_manager::Driver_manager(Interface_thread * Interface, double period,
+		std::string name) :
+		Thread(ORO_SCHED_OTHER, 0, period, ~0u, name), interface(Interface), request(
+				DRIVER_STATE_CLOSED), requestBus(0), requestSlot(0), requestBackendPtr(
+				NULL), bus(0), slot(0), state(DRIVER_STATE_CLOSED), lastResult(0), configureENC(
+				0), pendingENC(0), reopen(0), recoveries(0), retry(0) {
+}
+
+Driver_manager::~Driver_manager() {
+	stop();
+
+	delete requestBackendPtr;
+}
+
+void Driver_manager::requestOpen(std::string Device, int Bus, int Slot) {
+	//state is changed together with the request, so the thread
+	//finishing an older one can not overwrite it
+	mutexRequest.lock();
+	request = DRIVER_STATE_OPENING;
+	requestDevice = Device;
+	requestBus = Bus;
+	requestSlot = Slot;
+	state = DRIVER_STATE_OPENING;
+	mutexRequest.unlock();
+}
+
+void Driver_manager::requestClose(void) {
+	mutexRequest.lock();
+	request = DRIVER_STATE_CLOSING;
+	state = DRIVER_STATE_CLOSING;
+	mutexRequest.unlock();
+}
+
+void Driver_manager::requestBackend(Board_backend * Backend) {
+	mutexRequest.lock();
+	delete requestBackendPtr;
+	requestBackendPtr = Backend;
+
+	//open requested before is served on the old backend no more
+	request = DRIVER_STATE_CLOSING;
+	state = DRIVER_STATE_CLOSING;
+	mutexRequest.unlock();
+}
+
+void Driver_manager::requestENC(void) {
+	configureENC = 1;
+	pendingENC = 1;
+}
+
+int Driver_manager::getState(void) {
+	return state;
+}
+
+int Driver_manager::getLastResult(void) {
+	return lastResult;
+}
+
+unsigned int Driver_manager::getRecoveries(void) {
+	return recoveries;
+}
+
+void Driver_manager::shutdown(void) {
+	//no request may reopen the board after it is closed
+	stop();
+
+	mutexRequest.lock();
+	if (request == DRIVER_STATE_OPENING)
+		reopen = 1;
+	else if (state == DRIVER_STATE_OPEN || state == DRIVER_STATE_RECOVERING) {
+		requestDevice = device;
+		requestBus = bus;
+		requestSlot = slot;
+		reopen = 1;
+	}
+	request = DRIVER_STATE_CLOSED;
+	mutexRequest.unlock();
+
+	retry = 0;
+	lastResult = interface->stopDriver();
+
+	//a backend not applied yet keeps the board closing
+	finish(lastResult == 0 ? DRIVER_STATE_CLOSED : DRIVER_STATE_FAILED);
+}
+
+bool Driver_manager::initialize(void) {
+	mutexRequest.lock();
+	if (reopen && request == DRIVER_STATE_CLOSED) {
+		request = DRIVER_STATE_OPENING;
+		state = DRIVER_STATE_OPENING;
+	}
+	reopen = 0;
+	mutexRequest.unlock();
+
+	return true;
+}
+
+int Driver_manager::attach(void) {
+	int Error = interface->resetDriver(device, bus, slot);
+
+	if (Error == 0 && configureENC)
+		interface->prepareENC();
+
+	//failures seen before the board was attached do not count
+	interface->takeRecoveryRequest();
+
+	return Error;
+}
+
+void Driver_manager::finish(int State) {
+	mutexRequest.lock();
+	if (request == DRIVER_STATE_CLOSED && requestBackendPtr == NULL)
+		state = State;
+	mutexRequest.unlock();
+}
+
+void Driver_manager::step(void) {
+	RTT::os::TimeService * ts = RTT::os::TimeService::Instance();
+	Board_backend * Backend;
+	int Request;
+
+	mutexRequest.lock();
+	Request = request;
+	request = DRIVER_STATE_CLOSED;
+	Backend = requestBackendPtr;
+	requestBackendPtr = NULL;
+	if (Request == DRIVER_STATE_OPENING) {
+		device = requestDevice;
+		bus = requestBus;
+		slot = requestSlot;
+	}
+	mutexRequest.unlock();
+
+	//the old backend is closed and replaced before the board is opened
+	if (Backend != NULL) {
+		retry = 0;
+		lastResult = interface->setBackend(Backend);
+		if (lastResult < 0) {
+			finish(DRIVER_STATE_FAILED);
+			return;
+		}
+	}
+
+	if (Request == DRIVER_STATE_OPENING) {
+		retry = 0;
+		pendingENC = 0;
+		lastResult = attach();
+		finish(lastResult == 0 ? DRIVER_STATE_OPEN : DRIVER_STATE_FAILED);
+		return;
+	}
+
+	if (Request == DRIVER_STATE_CLOSING) {
+		retry = 0;
+		lastResult = interface->stopDriver();
+		finish(lastResult == 0 ? DRIVER_STATE_CLOSED : DRIVER_STATE_FAILED);
+		return;
+	}
+
+	if (Backend != NULL) {
+		finish(DRIVER_STATE_CLOSED);
+		return;
+	}
+
+	if (state == DRIVER_STATE_OPEN && pendingENC
+			&& __sync_lock_test_and_set(&pendingENC, 0))
+		interface->prepareENC();
+
+	//the watchdog is served only for a board which should be open
+	if (state == DRIVER_STATE_OPEN && interface->takeRecoveryRequest()) {
+		__sync_fetch_and_add(&recoveries, 1);
+		finish(DRIVER_STATE_RECOVERING);
+		retry = ts->getNSecs();
+	}
+
+	if (state != DRIVER_STATE_RECOVERING || retry == 0
+			|| ts->getNSecs() < retry)
+		return;
+
+	lastResult = attach();
+
+	if (lastResult == 0) {
+		retry = 0;
+		finish(DRIVER_STATE_OPEN);
+	} else
+		retry = ts->getNSecs()
+				+ (long long) (DRIVER_RETRY_PERIOD * 1000000000.0);
+}
@@ -0,0 +1,200 @@
+/**
+ * \file Driver-manager.hpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef DRIVER_MANAGER_HPP
+#define DRIVER_MANAGER_HPP
+
+#include <string>
+
+#include <rtt/os/Mutex.hpp>
+#include <rtt/os/Thread.hpp>
+
+#include "Interface-thread.hpp"
+
+#define DRIVER_STATE_CLOSED 0
+#define DRIVER_STATE_OPENING 1
+#define DRIVER_STATE_OPEN 2
+#define DRIVER_STATE_CLOSING 3
+#define DRIVER_STATE_FAILED 4
+#define DRIVER_STATE_RECOVERING 5
+
+/**
+ * Time between attempts to re-attach a board which
+ * could not be recovered, in seconds
+ */
+#define DRIVER_RETRY_PERIOD 1.0
+
+/**
+ * \brief Driver_manager
+ *
+ * Opens, closes and recovers the board of an Interface_thread
+ * on its own low priority thread.
+ *
+ * Requests only store what has to be done and return at once,
+ * their progress is polled with \link getState getState \endlink.
+ * While the board is open the thread takes recovery requests of the
+ * Interface_thread watchdog and re-attaches the board in the
+ * background, meanwhile the acquisition publishes stale frames.
+ */
+class Driver_manager: public RTT::os::Thread {
+public:
+
+	/**
+	 * \param[in]	Interface		Interface thread of the board, has to outlive
+	 * 												the manager
+	 * \param[in]	period			Period of the thread in seconds
+	 */
+	Driver_manager(Interface_thread * Interface, double period,
+			std::string name);
+
+	~Driver_manager();
+
+	/**
+	 * \brief requestOpen
+	 *
+	 * Requests the board to be (re)opened with the given parameters.
+	 */
+	void requestOpen(std::string Device, int Bus, int Slot);
+
+	void requestClose(void);
+
+	/**
+	 * \brief requestBackend
+	 *
+	 * Requests the board to be closed and its backend replaced,
+	 * before a following open is served. Backend replaced by
+	 * a later request before it was used is deleted.
+	 *
+	 * \param[in]	Backend		New backend, owned by the manager
+	 */
+	void requestBackend(Board_backend * Backend);
+
+	/**
+	 * \brief requestENC
+	 *
+	 * Requests encoders to be configured now, when the board
+	 * is open, and every time it is opened or recovered.
+	 */
+	void requestENC(void);
+
+	/**
+	 * \return		DRIVER_STATE_*, the state of the latest request
+	 * 						as soon as it is made
+	 */
+	int getState(void);
+
+	/**
+	 * \return		Result of the last open or close, 0 on success
+	 */
+	int getLastResult(void);
+
+	/**
+	 * \return		Number of recoveries started by the watchdog
+	 */
+	unsigned int getRecoveries(void);
+
+	/**
+	 * \brief shutdown
+	 *
+	 * Stops the thread and closes the board. A board which was
+	 * open or requested to open is opened again with the same
+	 * parameters when the thread is started again.
+	 */
+	void shutdown(void);
+
+	bool initialize(void);
+
+	void step(void);
+
+private:
+
+	/**
+	 * Opens the board, called by the thread
+	 */
+	int attach(void);
+
+	/**
+	 * Stores the state reached by the thread unless a new
+	 * request came meanwhile
+	 */
+	void finish(int State);
+
+	Interface_thread * interface;
+
+	RTT::os::Mutex mutexRequest;
+
+	/**
+	 * Request not taken yet by the thread, DRIVER_STATE_OPENING,
+	 * DRIVER_STATE_CLOSING or DRIVER_STATE_CLOSED for none
+	 */
+	int request;
+
+	std::string requestDevice;
+
+	int requestBus;
+
+	int requestSlot;
+
+	/**
+	 * Backend not applied yet, NULL for none
+	 */
+	Board_backend * requestBackendPtr;
+
+	/**
+	 * Parameters of the board, owned by the thread
+	 */
+	std::string device;
+
+	int bus;
+
+	int slot;
+
+	volatile int state;
+
+	volatile int lastResult;
+
+	volatile int configureENC;
+
+	/**
+	 * Encoders are configured in the next step of an open board
+	 */
+	volatile int pendingENC;
+
+	/**
+	 * The board is opened when the thread is started again
+	 */
+	int reopen;
+
+	volatile unsigned int recoveries;
+
+	/**
+	 * When the next recovery is attempted, 0 for none
+	 */
+	long long retry;
+};
+
+#endif
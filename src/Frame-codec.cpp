@@ -0,0 +1,217 @@
+/**
+ * \file Frame-codec.cpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include "Frame-codec.hpp"
+
+#include <cstring>
+
+namespace {
+
+int putVarint(unsigned char * Buffer, unsigned long long Value) {
+	int Size = 0;
+
+	while (Value >= 0x80) {
+		Buffer[Size++] = (unsigned char) (Value | 0x80);
+		Value >>= 7;
+	}
+	Buffer[Size++] = (unsigned char) Value;
+
+	return Size;
+}
+
+/**
+ * Small differences of both signs are encoded in few bytes
+ */
+int putSigned(unsigned char * Buffer, long long Value) {
+	return putVarint(Buffer,
+			((unsigned long long) Value << 1) ^ (unsigned long long) (Value >> 63));
+}
+
+bool getVarint(const unsigned char * Buffer, int Size, int & Offset,
+		unsigned long long & Value) {
+	int Shift = 0;
+
+	Value = 0;
+
+	while (Offset < Size && Shift < 64) {
+		unsigned char Byte = Buffer[Offset++];
+
+		Value |= (unsigned long long) (Byte & 0x7F) << Shift;
+		if (!(Byte & 0x80))
+			return true;
+
+		Shift += 7;
+	}
+
+	return false;
+}
+
+bool getSigned(const unsigned char * Buffer, int Size, int & Offset,
+		long long & Value) {
+	unsigned long long Raw;
+
+	if (!getVarint(Buffer, Size, Offset, Raw))
+		return false;
+
+	Value = (long long) (Raw >> 1) ^ -(long long) (Raw & 1);
+
+	return true;
+}
+
+/**
+ * Channels stored in the record, read or changed since the previous frame
+ */
+unsigned int present(unsigned int Valid, const int * Previous,
+		const int * Values, int Count) {
+	unsigned int Present = Valid;
+
+	for (int i = 0; i < Count; ++i)
+		if (Values[i] != Previous[i])
+			Present |= 1 << i;
+
+	return Present;
+}
+
+int putValues(unsigned char * Buffer, unsigned int Present,
+		const int * Previous, const int * Values, int Count) {
+	int Size = 0;
+
+	for (int i = 0; i < Count; ++i)
+		if (Present & (1 << i))
+			Size += putSigned(Buffer + Size,
+					(long long) Values[i] - (long long) Previous[i]);
+
+	return Size;
+}
+
+bool getValues(const unsigned char * Buffer, int Size, int & Offset,
+		unsigned int Present, unsigned int Valid, unsigned int Seq, int * Values,
+		unsigned int * Seqs, int Count) {
+	long long Delta;
+
+	for (int i = 0; i < Count; ++i) {
+		if (Present & (1 << i)) {
+			if (!getSigned(Buffer, Size, Offset, Delta))
+				return false;
+
+			Values[i] = (int) (Values[i] + Delta);
+		}
+
+		if (Valid & (1 << i))
+			Seqs[i] = Seq;
+	}
+
+	return true;
+}
+
+}
+
+void initRecordHeader(Record_header & Header) {
+	memset(&Header, 0, sizeof(Header));
+
+	strncpy(Header.magic, RECORD_MAGIC, sizeof(Header.magic));
+	Header.version = RECORD_VERSION;
+	Header.size = sizeof(Header);
+}
+
+bool checkRecordHeader(const Record_header & Header) {
+	return strncmp(Header.magic, RECORD_MAGIC, sizeof(Header.magic)) == 0
+			&& Header.version == RECORD_VERSION
+			&& Header.size >= sizeof(Record_header);
+}
+
+int encodeFrame(const S626_frame & Previous, const S626_frame & Frame,
+		unsigned char * Buffer) {
+	unsigned int PresentDIO, PresentADC, PresentENC;
+	int Size = 0;
+
+	PresentDIO = present(Frame.DIOValid, Previous.DIO, Frame.DIO,
+			BOARD_DIO_BANKS);
+	PresentADC = present(Frame.ADCValid, Previous.ADC, Frame.ADC,
+			BOARD_ADC_CHANNELS);
+	PresentENC = present(Frame.ENCValid, Previous.ENC, Frame.ENC,
+			BOARD_ENC_CHANNELS);
+
+	Size += putVarint(Buffer + Size, Frame.seq - Previous.seq);
+	Size += putSigned(Buffer + Size, Frame.timestamp - Previous.timestamp);
+	Size += putVarint(Buffer + Size, Frame.cycle - Previous.cycle);
+
+	Size += putVarint(Buffer + Size, Frame.DIOValid);
+	Size += putVarint(Buffer + Size, PresentDIO);
+	Size += putVarint(Buffer + Size, Frame.ADCValid);
+	Size += putVarint(Buffer + Size, PresentADC);
+	Size += putVarint(Buffer + Size, Frame.ENCValid);
+	Size += putVarint(Buffer + Size, PresentENC);
+
+	Size += putValues(Buffer + Size, PresentDIO, Previous.DIO, Frame.DIO,
+			BOARD_DIO_BANKS);
+	Size += putValues(Buffer + Size, PresentADC, Previous.ADC, Frame.ADC,
+			BOARD_ADC_CHANNELS);
+	Size += putValues(Buffer + Size, PresentENC, Previous.ENC, Frame.ENC,
+			BOARD_ENC_CHANNELS);
+
+	return Size;
+}
+
+int decodeFrame(S626_frame & Frame, const unsigned char * Buffer, int Size) {
+	unsigned long long Seq, Cycle;
+	unsigned long long DIOValid, PresentDIO, ADCValid, PresentADC, ENCValid,
+			PresentENC;
+	long long Timestamp;
+	int Offset = 0;
+
+	if (!getVarint(Buffer, Size, Offset, Seq)
+			|| !getSigned(Buffer, Size, Offset, Timestamp)
+			|| !getVarint(Buffer, Size, Offset, Cycle)
+			|| !getVarint(Buffer, Size, Offset, DIOValid)
+			|| !getVarint(Buffer, Size, Offset, PresentDIO)
+			|| !getVarint(Buffer, Size, Offset, ADCValid)
+			|| !getVarint(Buffer, Size, Offset, PresentADC)
+			|| !getVarint(Buffer, Size, Offset, ENCValid)
+			|| !getVarint(Buffer, Size, Offset, PresentENC))
+		return -1;
+
+	Frame.seq += (unsigned int) Seq;
+	Frame.timestamp += Timestamp;
+	Frame.cycle += (unsigned int) Cycle;
+	Frame.DIOValid = (unsigned int) DIOValid;
+	Frame.ADCValid = (unsigned int) ADCValid;
+	Frame.ENCValid = (unsigned int) ENCValid;
+
+	if (!getValues(Buffer, Size, Offset, (unsigned int) PresentDIO,
+			Frame.DIOValid, Frame.seq, Frame.DIO, Frame.DIOSeq, BOARD_DIO_BANKS)
+			|| !getValues(Buffer, Size, Offset, (unsigned int) PresentADC,
+					Frame.ADCValid, Frame.seq, Frame.ADC, Frame.ADCSeq,
+					BOARD_ADC_CHANNELS)
+			|| !getValues(Buffer, Size, Offset, (unsigned int) PresentENC,
+					Frame.ENCValid, Frame.seq, Frame.ENC, Frame.ENCSeq,
+					BOARD_ENC_CHANNELS))
+		return -1;
+
+	return Offset;
+}
@@ -0,0 +1,120 @@
+/**
+ * \file Frame-codec.hpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef FRAME_CODEC_HPP
+#define FRAME_CODEC_HPP
+
+#include "s626_task-types.hpp"
+
+/**
+ * Upper bound of an encoded frame in bytes
+ */
+#define FRAME_CODEC_MAX_SIZE 256
+
+#define RECORD_MAGIC "S626REC"
+#define RECORD_VERSION 1
+
+/**
+ * \brief Record_header
+ *
+ * Header at the beginning of a recording, followed
+ * by frames encoded with \link encodeFrame encodeFrame \endlink.
+ */
+struct Record_header {
+	char magic[8];
+
+	unsigned int version;
+
+	/**
+	 * Size of the header in bytes, frames start at this offset
+	 */
+	unsigned int size;
+
+	/**
+	 * Bytes of encoded frames following the header
+	 */
+	unsigned long long used;
+
+	/**
+	 * Number of recorded frames
+	 */
+	unsigned long long frames;
+
+	/**
+	 * Number of frames lost because the recorder did not keep up
+	 * or the file was full
+	 */
+	unsigned long long dropped;
+
+	char reserved[24];
+};
+
+/**
+ * \brief initRecordHeader
+ *
+ * Fills header of an empty recording.
+ */
+void initRecordHeader(Record_header & Header);
+
+/**
+ * \brief checkRecordHeader
+ *
+ * \return		true when the header belongs to a supported recording
+ */
+bool checkRecordHeader(const Record_header & Header);
+
+/**
+ * \brief encodeFrame
+ *
+ * Encodes differences of the frame against the previous one.
+ * Sequence numbers, timestamp and values are stored as variable
+ * length deltas, only channels which were read or changed are stored.
+ * The first frame is encoded against a zeroed frame.
+ *
+ * \param[in]	Previous		Previously encoded frame
+ * \param[in]	Frame				Frame to be encoded
+ * \param[out]	Buffer		At least FRAME_CODEC_MAX_SIZE bytes
+ *
+ * \return		Number of written bytes
+ */
+int encodeFrame(const S626_frame & Previous, const S626_frame & Frame,
+		unsigned char * Buffer);
+
+/**
+ * \brief decodeFrame
+ *
+ * \param[in,out]	Frame		Previously decoded frame on input,
+ * 												the decoded frame on output
+ * \param[in]	Buffer			Encoded data
+ * \param[in]	Size				Number of available bytes
+ *
+ * \return		Number of consumed bytes or -1 when the data is truncated
+ */
+int decodeFrame(S626_frame & Frame, const unsigned char * Buffer, int Size);
+
+#endif
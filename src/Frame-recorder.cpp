@@ -0,0 +1,218 @@
+/**
+ * \file Frame-recorder.cpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include "Frame-recorder.hpp"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+Frame_recorder::Frame_recorder(double period, std::string name) :
+		Thread(ORO_SCHED_OTHER, 0, period, ~0u, name), session(0), sessions(0), lost(
+				0), fd(-1), map(NULL), mapSize(0), header(NULL), counted(0), frames(
+				0), dropped(0) {
+	memset(&previous, 0, sizeof(previous));
+}
+
+Frame_recorder::~Frame_recorder() {
+	close();
+}
+
+int Frame_recorder::open(std::string File, unsigned long long Size) {
+	mutexFile.lock();
+
+	if (map != NULL) {
+		mutexFile.unlock();
+		return -1;
+	}
+
+	if (Size < sizeof(Record_header) + FRAME_CODEC_MAX_SIZE)
+		Size = sizeof(Record_header) + FRAME_CODEC_MAX_SIZE;
+
+	fd = ::open(File.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		mutexFile.unlock();
+		return -2;
+	}
+
+	//blocks are allocated now, not when the frames are written
+	if (posix_fallocate(fd, 0, Size) != 0) {
+		::close(fd);
+		fd = -1;
+		mutexFile.unlock();
+		return -2;
+	}
+
+	void * Map = mmap(NULL, Size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (Map == MAP_FAILED) {
+		::close(fd);
+		fd = -1;
+		mutexFile.unlock();
+		return -2;
+	}
+
+	map = (unsigned char *) Map;
+	mapSize = Size;
+
+	header = (Record_header *) map;
+	initRecordHeader(*header);
+
+	memset(&previous, 0, sizeof(previous));
+	counted = lost;
+	frames = 0;
+	dropped = 0;
+
+	//frames of the previous recording left in the ring are skipped
+	if (++sessions == 0)
+		sessions = 1;
+	session = sessions;
+
+	mutexFile.unlock();
+
+	return 0;
+}
+
+void Frame_recorder::close(void) {
+	mutexFile.lock();
+
+	if (map == NULL) {
+		mutexFile.unlock();
+		return;
+	}
+
+	session = 0;
+
+	//frames pushed before the session ended
+	write();
+
+	unsigned long long Used = header->size + header->used;
+
+	msync(map, Used, MS_SYNC);
+	munmap(map, mapSize);
+	map = NULL;
+	header = NULL;
+
+	if (ftruncate(fd, Used) != 0) {
+		//file keeps its preallocated size, readers use the header
+	}
+	::close(fd);
+	fd = -1;
+
+	mutexFile.unlock();
+}
+
+bool Frame_recorder::isRecording(void) {
+	return session != 0;
+}
+
+void Frame_recorder::push(const S626_frame & Frame) {
+	unsigned int Session = session;
+	Entry Item;
+
+	if (Session == 0)
+		return;
+
+	Item.session = Session;
+	Item.frame = Frame;
+
+	if (!ring.push(Item))
+		__sync_fetch_and_add(&lost, 1);
+}
+
+unsigned long long Frame_recorder::getFrames(void) {
+	unsigned long long Frames;
+
+	mutexFile.lock();
+	Frames = frames;
+	mutexFile.unlock();
+
+	return Frames;
+}
+
+unsigned long long Frame_recorder::getDropped(void) {
+	unsigned long long Dropped;
+
+	mutexFile.lock();
+	Dropped = dropped;
+	mutexFile.unlock();
+
+	return Dropped;
+}
+
+bool Frame_recorder::initialize(void) {
+	return true;
+}
+
+void Frame_recorder::step(void) {
+	mutexFile.lock();
+	write();
+	mutexFile.unlock();
+}
+
+void Frame_recorder::write(void) {
+	const Entry * Item;
+	unsigned char Buffer[FRAME_CODEC_MAX_SIZE];
+	int Size;
+
+	while ((Item = ring.front()) != NULL) {
+		if (header == NULL || Item->session != sessions) {
+			ring.pop();
+			continue;
+		}
+
+		Size = encodeFrame(previous, Item->frame, Buffer);
+
+		if (header->size + header->used + Size > mapSize) {
+			//file is full, the rest of the recording is dropped
+			++header->dropped;
+		} else {
+			memcpy(map + header->size + header->used, Buffer, Size);
+			previous = Item->frame;
+
+			//data is in place before it is accounted
+			__sync_synchronize();
+			header->used += Size;
+			++header->frames;
+		}
+
+		ring.pop();
+	}
+
+	if (header == NULL)
+		return;
+
+	//frames which did not fit into the ring
+	unsigned int Lost = lost;
+	header->dropped += Lost - counted;
+	counted = Lost;
+
+	frames = header->frames;
+	dropped = header->dropped;
+}
@@ -0,0 +1,175 @@
+/**
+ * \file Frame-recorder.hpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef FRAME_RECORDER_HPP
+#define FRAME_RECORDER_HPP
+
+#include <string>
+
+#include <rtt/os/Mutex.hpp>
+#include <rtt/os/Thread.hpp>
+
+#include "Aligned-alloc.hpp"
+#include "Spsc-ring.hpp"
+#include "Frame-codec.hpp"
+#include "s626_task-types.hpp"
+
+/**
+ * Number of frames buffered between the acquisition and the writer
+ */
+#define RECORDER_RING_SIZE 1024
+
+/**
+ * \brief Frame_recorder
+ *
+ * Records every acquired frame into a binary file.
+ *
+ * The acquisition thread only copies the frame into a lock-free
+ * ring. A low priority thread encodes the frames with
+ * \link encodeFrame encodeFrame \endlink into a preallocated file
+ * mapped into memory, so neither disk access nor page faults
+ * happen in the acquisition thread. Frames which do not fit
+ * into the ring or the file are counted as dropped.
+ */
+class Frame_recorder: public RTT::os::Thread, public Aligned_alloc {
+public:
+
+	/**
+	 * \param[in]	period		Period of the writer in seconds, the ring
+	 * 											has to hold all frames acquired meanwhile
+	 */
+	Frame_recorder(double period, std::string name);
+
+	~Frame_recorder();
+
+	/**
+	 * \brief open
+	 *
+	 * Creates the file and starts recording.
+	 *
+	 * \param[in]	File		Path of the recording, overwritten when it exists
+	 * \param[in]	Size		Size of the file preallocated in bytes
+	 *
+	 * \return		0 on success, -1 when the recorder is already recording,
+	 * 						-2 when the file could not be created
+	 */
+	int open(std::string File, unsigned long long Size);
+
+	/**
+	 * \brief close
+	 *
+	 * Stops recording, writes the buffered frames and
+	 * truncates the file to the recorded data.
+	 */
+	void close(void);
+
+	bool isRecording(void);
+
+	/**
+	 * \brief push
+	 *
+	 * Adds the frame to the recording. Called only by the acquisition
+	 * thread, never blocks. Does nothing when not recording.
+	 */
+	void push(const S626_frame & Frame);
+
+	/**
+	 * \return		Number of frames written to the current or last file
+	 */
+	unsigned long long getFrames(void);
+
+	/**
+	 * \return		Number of frames dropped in the current or last file
+	 */
+	unsigned long long getDropped(void);
+
+	bool initialize(void);
+
+	void step(void);
+
+private:
+
+	/**
+	 * Frame tagged with the recording it belongs to
+	 */
+	struct Entry {
+		unsigned int session;
+		S626_frame frame;
+	};
+
+	/**
+	 * Encodes the buffered frames into the file
+	 */
+	void write(void);
+
+	Spsc_ring<Entry, RECORDER_RING_SIZE> ring;
+
+	/**
+	 * Number of the current recording, 0 when not recording
+	 */
+	volatile unsigned int session;
+
+	unsigned int sessions;
+
+	/**
+	 * Frames dropped by the acquisition thread
+	 */
+	volatile unsigned int lost;
+
+	/**
+	 * Serializes the writer with open and close
+	 */
+	RTT::os::Mutex mutexFile;
+
+	int fd;
+
+	unsigned char * map;
+
+	unsigned long long mapSize;
+
+	Record_header * header;
+
+	/**
+	 * Last written frame, encoding base of the next one
+	 */
+	S626_frame previous;
+
+	/**
+	 * Drops already counted in the header
+	 */
+	unsigned int counted;
+
+	/**
+	 * Statistics of the current or last recording
+	 */
+	unsigned long long frames;
+
+	unsigned long long dropped;
+};
+
+#endif
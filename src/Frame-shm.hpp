@@ -0,0 +1,337 @@
+/**
+ * \file Frame-shm.hpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef FRAME_SHM_HPP
+#define FRAME_SHM_HPP
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <new>
+#include <string>
+
+#include "Seqlock.hpp"
+#include "s626_task-types.hpp"
+
+/**
+ * "S626" in the first bytes of a segment
+ */
+#define FRAME_SHM_MAGIC 0x36323653u
+#define FRAME_SHM_VERSION 1
+
+/**
+ * \brief Frame_shm_segment
+ *
+ * Layout of the POSIX shared memory segment with the latest
+ * frame of an Interface_thread.
+ */
+struct Frame_shm_segment {
+	unsigned int magic;
+
+	unsigned int version;
+
+	/**
+	 * Size of the segment, checked by readers together
+	 * with the version
+	 */
+	unsigned int size;
+
+	Seqlock<S626_frame> frame;
+};
+
+/**
+ * \brief Frame_shm_writer
+ *
+ * Creates the segment and publishes frames into it.
+ *
+ * \link publish publish \endlink is real-time safe and may run
+ * concurrently with \link open open \endlink and \link close
+ * close \endlink, frames published while the segment is being
+ * opened or closed are skipped.
+ */
+class Frame_shm_writer {
+public:
+
+	Frame_shm_writer() :
+			segment(NULL), busy(0) {
+	}
+
+	~Frame_shm_writer() {
+		close();
+	}
+
+	/**
+	 * \brief open
+	 *
+	 * Creates or reuses the segment.
+	 *
+	 * \param[in]	Name		Name of the segment, ex. /s626
+	 *
+	 * \return		false when the segment could not be created
+	 */
+	bool open(const std::string & Name) {
+		Frame_shm_segment * Segment;
+		void * Map;
+		int File;
+
+		close();
+
+		File = shm_open(Name.c_str(), O_CREAT | O_RDWR, 0644);
+		if (File < 0)
+			return false;
+
+		if (ftruncate(File, sizeof(Frame_shm_segment)) != 0) {
+			::close(File);
+			return false;
+		}
+
+		Map = mmap(NULL, sizeof(Frame_shm_segment), PROT_READ | PROT_WRITE,
+				MAP_SHARED, File, 0);
+		::close(File);
+
+		if (Map == MAP_FAILED)
+			return false;
+
+		//pages are never swapped out under the real-time thread
+		mlock(Map, sizeof(Frame_shm_segment));
+
+		//readers check the magic last
+		Segment = new (Map) Frame_shm_segment();
+		Segment->version = FRAME_SHM_VERSION;
+		Segment->size = sizeof(Frame_shm_segment);
+		__sync_synchronize();
+		Segment->magic = FRAME_SHM_MAGIC;
+
+		lock();
+		segment = Segment;
+		name = Name;
+		unlock();
+
+		return true;
+	}
+
+	/**
+	 * \brief close
+	 *
+	 * Unmaps and removes the segment, readers which have
+	 * it mapped keep the last frame.
+	 */
+	void close(void) {
+		lock();
+
+		if (segment) {
+			munmap(segment, sizeof(Frame_shm_segment));
+			shm_unlink(name.c_str());
+			segment = NULL;
+		}
+
+		unlock();
+	}
+
+	bool isOpen(void) const {
+		return segment != NULL;
+	}
+
+	/**
+	 * \brief publish
+	 *
+	 * Copies the frame into the segment, never blocks.
+	 */
+	void publish(const S626_frame & Frame) {
+		if (__sync_lock_test_and_set(&busy, 1))
+			return;
+
+		if (segment)
+			segment->frame.write(Frame);
+
+		__sync_lock_release(&busy);
+	}
+
+private:
+
+	void lock(void) {
+		while (__sync_lock_test_and_set(&busy, 1))
+			sched_yield();
+	}
+
+	void unlock(void) {
+		__sync_lock_release(&busy);
+	}
+
+	Frame_shm_segment * volatile segment;
+
+	std::string name;
+
+	/**
+	 * Held by publish and while the mapping changes
+	 */
+	volatile int busy;
+};
+
+/**
+ * \brief Frame_shm_reader
+ *
+ * Maps the segment of another process read only. Depends only
+ * on this header, Seqlock.hpp, s626_task-types.hpp and
+ * Board-backend.hpp, link with -lrt on older C libraries.
+ *
+ * Example
+ * \code
+ * Frame_shm_reader Reader;
+ * S626_frame Frame;
+ *
+ * if (Reader.open("/s626"))
+ *   while (running)
+ *     if (Reader.poll(Frame))
+ *       use(Frame.ADC[0]);
+ * \endcode
+ */
+class Frame_shm_reader {
+public:
+
+	Frame_shm_reader() :
+			segment(NULL), last(0) {
+	}
+
+	~Frame_shm_reader() {
+		close();
+	}
+
+	/**
+	 * \brief open
+	 *
+	 * \return		false when the segment does not exist
+	 * 						or has a different layout
+	 */
+	bool open(const std::string & Name) {
+		struct stat Stat;
+		void * Map;
+		int File;
+
+		close();
+
+		File = shm_open(Name.c_str(), O_RDONLY, 0);
+		if (File < 0)
+			return false;
+
+		if (fstat(File, &Stat) != 0
+				|| Stat.st_size < (off_t) sizeof(Frame_shm_segment)) {
+			::close(File);
+			return false;
+		}
+
+		Map = mmap(NULL, sizeof(Frame_shm_segment), PROT_READ, MAP_SHARED, File,
+				0);
+		::close(File);
+
+		if (Map == MAP_FAILED)
+			return false;
+
+		segment = (const Frame_shm_segment *) Map;
+
+		if (segment->magic != FRAME_SHM_MAGIC
+				|| segment->version != FRAME_SHM_VERSION
+				|| segment->size != sizeof(Frame_shm_segment)) {
+			close();
+			return false;
+		}
+
+		last = 0;
+
+		return true;
+	}
+
+	void close(void) {
+		if (segment) {
+			munmap((void *) segment, sizeof(Frame_shm_segment));
+			segment = NULL;
+		}
+	}
+
+	bool isOpen(void) const {
+		return segment != NULL;
+	}
+
+	/**
+	 * \brief poll
+	 *
+	 * Takes the newest frame if it was not taken yet. Wait free,
+	 * makes a single attempt and never waits for the writer.
+	 *
+	 * \return		false when there is no new frame or the
+	 * 						copy overlapped a write, Frame may then
+	 * 						be partially overwritten
+	 */
+	bool poll(S626_frame & Frame) {
+		unsigned int Version;
+
+		if (segment->frame.version() == last)
+			return false;
+
+		//the version is the one validated by the copy, a frame
+		//written after the check above is not skipped later
+		if (!segment->frame.tryRead(Frame, &Version) || Version == last)
+			return false;
+
+		last = Version;
+
+		return true;
+	}
+
+	/**
+	 * \brief read
+	 *
+	 * Copies the newest frame, retries while it overlaps a write.
+	 */
+	void read(S626_frame & Frame) {
+		last = segment->frame.read(Frame);
+	}
+
+	/**
+	 * \brief version
+	 *
+	 * \return		Number of frames published into the segment
+	 */
+	unsigned int version(void) const {
+		return segment->frame.version();
+	}
+
+private:
+
+	const Frame_shm_segment * segment;
+
+	/**
+	 * Version of the last frame taken by poll
+	 */
+	unsigned int last;
+};
+
+#endif
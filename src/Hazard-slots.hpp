@@ -0,0 +1,155 @@
+/**
+ * \file Hazard-slots.hpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef HAZARD_SLOTS_HPP
+#define HAZARD_SLOTS_HPP
+
+#include <cstddef>
+
+/**
+ * \brief Hazard_slots
+ *
+ * Publishes immutable tables to a single reader without locks.
+ *
+ * Writers fill a free slot and swap it in atomically.
+ * The reader announces the table it uses, that table and
+ * the published one are never reused, so three slots
+ * always leave one free and writers do not wait.
+ * Writers have to be serialized by the caller.
+ *
+ * T has to be a POD type.
+ */
+template<class T>
+class Hazard_slots {
+public:
+
+	Hazard_slots() {
+		for (int i = 0; i < 3; ++i)
+			slots[i] = T();
+
+		published = &slots[0];
+		hazard = NULL;
+	}
+
+	/**
+	 * \brief prepare
+	 *
+	 * \return		Slot the next table can be written into,
+	 * 						initialized with the published table
+	 */
+	T * prepare(void) {
+		T * Table = NULL;
+
+		//hazard has to be read after the last publication
+		__sync_synchronize();
+
+		for (int i = 0; i < 3; ++i) {
+			if (&slots[i] != published && &slots[i] != hazard) {
+				Table = &slots[i];
+				break;
+			}
+		}
+
+		*Table = *published;
+
+		return Table;
+	}
+
+	/**
+	 * \brief publish
+	 *
+	 * Makes the table returned by \link prepare prepare \endlink
+	 * visible to the reader.
+	 */
+	void publish(T * Table) {
+		//table contents are visible before the pointer
+		__sync_synchronize();
+
+		published = Table;
+	}
+
+	/**
+	 * \brief acquire
+	 *
+	 * Takes the published table. Called only by the reader,
+	 * the table stays valid until the next call or
+	 * \link release release \endlink.
+	 */
+	const T * acquire(void) {
+		T * Table;
+
+		//announce the table and make sure it was not
+		//replaced before the announcement became visible
+		do {
+			Table = published;
+			hazard = Table;
+			__sync_synchronize();
+		} while (Table != published);
+
+		return Table;
+	}
+
+	/**
+	 * \brief release
+	 *
+	 * Tells writers the reader does not use any table.
+	 */
+	void release(void) {
+		__sync_synchronize();
+		hazard = NULL;
+	}
+
+	/**
+	 * \brief getPublished
+	 *
+	 * Published table for writers, which are serialized.
+	 */
+	const T * getPublished(void) const {
+		return published;
+	}
+
+	/**
+	 * \return		true while the reader may use the table
+	 */
+	bool isUsed(const T * Table) const {
+		__sync_synchronize();
+		return hazard == Table;
+	}
+
+private:
+
+	T slots[3];
+
+	T * volatile published;
+
+	/**
+	 * Table used by the reader
+	 */
+	T * volatile hazard;
+};
+
+#endif
@@ -27,185 +27,592 @@
 
 #include "Interface-thread.hpp"
 
+#include <cstring>
+
+#include <rtt/os/TimeService.hpp>
+
+#include <errno.h>
+#include <unistd.h>
+
 Interface_thread::Interface_thread(int scheduler, int priority, double period,
 		unsigned int cpu_affinity, std::string name) :
-		Thread(scheduler, priority, period, cpu_affinity, name), s626(NULL), state(
-				0) {
+		Thread(scheduler, priority, period, cpu_affinity, name), backend(NULL), clearENC(
+				0), state(0) {
+#ifndef S626_NO_ANALOGY
+	backend = createBoardBackend("analogy");
+#else
+	backend = createBoardBackend("sim");
+#endif
+
 	for(int i = 0; i < 6; ++i)
 	{
 		DIO_config[i] = 0;
 	}
 
+	for (int i = 0; i < BOARD_DAC_CHANNELS; ++i)
+		stagedDAC[i] = 0;
+	for (int i = 0; i < BOARD_DIO_BANKS; ++i) {
+		stagedDIO[i] = 0;
+		outputDIO[i] = 0;
+	}
+	stagedOutputs = 0;
+	coalescedWrites = 0;
+
 	ADC_config = 0;
+	ENC_config = 0;
+	ADC_range = 0;
+	rangeADC = -1;
+
+	frameADC = frameENC = frameDIO = -1;
+
+	for (int i = 0; i < BOARD_ADC_CHANNELS; ++i)
+		ADC_divider[i] = 1;
+	for (int i = 0; i < BOARD_ENC_CHANNELS; ++i)
+		ENC_divider[i] = 1;
+	for (int i = 0; i < BOARD_DIO_BANKS; ++i)
+		DIO_divider[i] = 1;
+	schedule(0, 0, 0);
+	tick = 0;
+
+	ADC_mode = INTERFACE_ADC_MODE_SYNC;
+	ADC_scan_period = 100000;
+	scanADC = -1;
+	scanPeriod = 0;
+
+	cycleTable = NULL;
+	recorder = NULL;
+	diag = NULL;
+	shm = NULL;
+	cycleReady = false;
+	cycleStale = false;
+	cycleBacklog = false;
+	acknowledged = 0;
+	cycleADC = cycleENC = cycleDIO = 0;
+
+	readFailures = 0;
+	watchdogLimit = 0;
+	recoveryRequested = 0;
+
+	mutexConfig.lock();
+	compile();
+	mutexConfig.unlock();
+
+	deadlineMisses = 0;
+	resetMisses = 0;
+	nextWakeup = 0;
+	cyclePeriod = 0;
+	resyncWakeup = 0;
+	trigger = NULL;
+	triggering = 0;
+
+	memset(&acquired, 0, sizeof(acquired));
+	frame.write(acquired);
+
+	edgeValid = 0;
+	clearEdges = 0;
+	edgeOverflow = 0;
+	for (int i = 0; i < BOARD_DIO_BANKS; ++i) {
+		edgeDIO[i] = 0;
+		for (int j = 0; j < 16; ++j)
+			risingDIO[i][j] = fallingDIO[i][j] = 0;
+	}
+}
+
+Interface_thread::~Interface_thread() {
+	stopDriver();
+
+	delete backend;
+}
+
+bool Interface_thread::initialize(void) {
+	//ideal release is taken from the first cycle
+	nextWakeup = 0;
+
+	return true;
 }
 
 void Interface_thread::step(void) {
-	int Datai;
-	int Activity = 0;
-	std::vector<int> Data;
-	int tmp;
+	RTT::os::TimeService * ts = RTT::os::TimeService::Instance();
+	long long Start = ts->getNSecs();
+	long long Period = getPeriodNS();
 
-	/*
-	 //time measure service
+	startCycle(Start, Period);
 
-	 RTIME t1 = rt_timer_read();
-	 */
+	acquire();
 
-	mutexActivity.lock();
-	Activity = this->state;
-	mutexActivity.unlock();
+	finishCycle(Start, ts->getNSecs(), Period);
+}
 
-	if (Activity > 0) {
+void Interface_thread::startCycle(long long Start, long long Period) {
+	long long Latency = 0;
 
-		mutexCard.lock();
-		if (s626) {
-			mutexCard.unlock();
+	//the engine drives the cycles with its own period
+	cyclePeriod = Period;
 
-			if (INTERFACE_ACTIVITY_MASK_DIO & Activity) {
-				//read all DIO
-				Data.clear();
-				for (int i = 0; i < 3; ++i) {
-					mutexCard.lock();
-					err = s626_dio_read(s626, i + 2, 0, &Datai);
-					mutexCard.unlock();
-
-					if (err < 0) {
-						std::cout << "error";
-						return;
-					}
-
-					mutexData.lock();
-					DIO[i] = Datai;
-					mutexData.unlock();
-				}
-			}
+	if (resetMisses) {
+		deadlineMisses = 0;
+		resetMisses = 0;
+	}
 
-			if (INTERFACE_ACTIVITY_MASK_ENC & Activity) {
-				//read all ENC
-				Data.clear();
-				for (int i = 0; i < 6; ++i) {
+	//period was changed
+	if (resyncWakeup) {
+		nextWakeup = 0;
+		resyncWakeup = 0;
+	}
 
-					mutexConfig.lock();
-					if( ENC_config & (1 << i))
-					{
-						mutexConfig.unlock();
+	if (nextWakeup != 0)
+		Latency = Start - nextWakeup;
 
-						mutexCard.lock();
-						err = s626_gpct_read_enc(s626, 5, i, &Datai);
-						mutexCard.unlock();
+	//release more than a period late, resynchronize
+	if (nextWakeup == 0 || Latency > Period) {
+		if (nextWakeup != 0)
+			++deadlineMisses;
+		nextWakeup = Start;
+	}
 
-						if (err < 0) {
-							std::cout << "error";
-							return;
-						}
+	stats[INTERFACE_STAGE_WAKEUP].record(Latency > 0 ? Latency : 0);
+}
 
-						mutexData.lock();
-						ENC[i] = Datai;
-						mutexData.unlock();
+void Interface_thread::finishCycle(long long Start, long long End,
+		long long Period) {
+	stats[INTERFACE_STAGE_STEP].record(End - Start);
 
-						//avoid next unlock of mutexConfig
-						continue;
-					}
-					mutexConfig.unlock();
+	nextWakeup += Period;
 
-				}
-			}
+	if (Period > 0 && End > nextWakeup)
+		++deadlineMisses;
+}
 
-			if (INTERFACE_ACTIVITY_MASK_ADC & Activity) {
-				//read ADC
-				Data.clear();
-				for (int i = 0; i < 16; ++i) {
+void Interface_thread::acquire(void) {
+	RTT::os::TimeService * ts = RTT::os::TimeService::Instance();
+	long long Deadline = ts->getNSecs()
+			+ getPeriodNS() * INTERFACE_BACKLOG_SHARE / 100;
+	TIME_SPEC Poll;
 
-					mutexConfig.lock();
-					if( ADC_config & (1 << i))
-					{
-						mutexConfig.unlock();
+	Poll.tv_sec = 0;
+	Poll.tv_nsec = INTERFACE_BACKLOG_POLL;
 
-						mutexCard.lock();
-						err = s626_adc_read(s626, 0, i, (char *) (&Datai), 1);
-						mutexCard.unlock();
+	do {
+		if (prepareCycle())
+			readCycle(ts->getNSecs());
 
-						if (err < 0) {
-							std::cout << "error";
-							return;
-						}
+		//cycles of the own thread are numbered by frames
+		publishCycle(acquired.seq + 1);
 
-						mutexData.lock();
-						ADC[i] = Datai & 0x3FFF;
-						mutexData.unlock();
+		if (!cycleBacklog)
+			return;
 
-						//avoid next unlock of mutexConfig
-						continue;
-					}
-					mutexConfig.unlock();
+		//replay as fast as possible is bounded by the consumer, which
+		//may run on the same CPU with lower priority, so sleep instead
+		//of spinning until it took the frame
+		while (trigger != NULL && acknowledged != acquired.seq) {
+			if (ts->getNSecs() + INTERFACE_BACKLOG_POLL >= Deadline)
+				return;
+			rtos_nanosleep(&Poll, NULL);
+		}
+	} while (ts->getNSecs() < Deadline);
+}
 
-				}
-			}
+bool Interface_thread::prepareCycle(void) {
+	int ADCMask, ENCMask, DIOMask;
+	int ScanMask;
+
+	cycleReady = false;
+	cycleStale = false;
+	cycleBacklog = false;
+
+	//configuration changed by other threads is taken at the cycle boundary
+	const Channel_table * Table = tables.acquire();
+	cycleTable = Table;
+
+	//waveform samples due in this tick are staged like any other write
+	int Waveform[BOARD_DAC_CHANNELS];
+	int WaveformMask = waveform.next(Waveform);
+	for (int i = 0; i < BOARD_DAC_CHANNELS; ++i)
+		if (WaveformMask & (1 << i))
+			setDAC(i, Waveform[i]);
+
+	//outputs are written also when publishing is disabled
+	flushOutputs(Table);
+
+	if (__sync_lock_test_and_set(&clearENC, 0)) {
+		for (int i = 0; i < 6; ++i)
+			acquired.ENC[i] = 0;
+	}
+
+	ADCMask = Table->ADC.mask;
+	ENCMask = Table->ENC.mask;
+	DIOMask = Table->DIO.mask;
+	ScanMask = Table->scanADC;
+
+	if (ADCMask == 0 && ENCMask == 0 && DIOMask == 0 && ScanMask == 0)
+		return false;
+
+	//channels due in this cycle
+	cycleADC = due(tick, Table->ADC);
+	cycleENC = due(tick, Table->ENC);
+	cycleDIO = due(tick, Table->DIO);
 
-			/*
-			 //time measure service
+	++tick;
 
-			 RTIME t2 = rt_timer_read();
-			 std::cout << (float) (t2 - t1) / 1000.0 << " us\n";
-			 */
+	//the card is busy while the driver is opened or reset, last
+	//values are published as stale instead of waiting for it
+	if (!mutexCard.trylock()) {
+		cycleStale = true;
+		return false;
+	}
+
+	if (!backend->isOpen()) {
+		mutexCard.unlock();
+		cycleStale = true;
+		return false;
+	}
+
+	if (Table->rangeADC != rangeADC) {
+		backend->setrangeADC(0xFFFF, Table->rangeADC);
+		rangeADC = Table->rangeADC;
+	}
+
+	//instruction list is rebuilt only when channels change
+	if (ADCMask != frameADC || ENCMask != frameENC || DIOMask != frameDIO) {
+		int Error = backend->configureFrame(ADCMask, ENCMask, DIOMask);
+
+		if (Error < 0) {
+			int Masks[BOARD_PERIPHERALS] = { ADCMask, 0, ENCMask, DIOMask };
 
-		} else {
 			mutexCard.unlock();
+			reportList(DIAG_CODE_CONFIGURE_FRAME, Masks, Error);
+			failed();
+			return false;
 		}
+
+		frameADC = ADCMask;
+		frameENC = ENCMask;
+		frameDIO = DIOMask;
 	}
 
+	if (ScanMask != scanADC || (ScanMask && Table->scanPeriod != scanPeriod)) {
+		if (scanADC > 0)
+			backend->stopADCScan();
+
+		scanADC = ScanMask;
+		scanPeriod = Table->scanPeriod;
+
+		if (ScanMask) {
+			int Error = backend->startADCScan(ScanMask, scanPeriod);
+
+			if (Error < 0) {
+				scanADC = -1;
+				mutexCard.unlock();
+				report(DIAG_CODE_START_SCAN, BOARD_PERIPHERAL_ADC, -1, Error);
+				failed();
+				return false;
+			}
+		}
+	}
+
+	mutexCard.unlock();
+
+	cycleReady = true;
+
+	return true;
 }
 
-int Interface_thread::resetDriver(std::string Device, int Bus, int Slot) {
+void Interface_thread::readCycle(long long Timestamp) {
+	int Scans = 0;
+	int Error;
 
-	err = stopDriver();
+	if (!cycleReady)
+		return;
 
-	mutexCard.lock();
+	RTT::os::TimeService * ts = RTT::os::TimeService::Instance();
 
-	if (err < 0) {
-		mutexCard.unlock();
-		return -1;
+	if (!mutexCard.trylock()) {
+		cycleReady = false;
+		cycleStale = true;
+		return;
 	}
 
-	char * DeviceChar;
+	long long Begin = ts->getNSecs();
 
-	DeviceChar = new char[Device.size()];
-	strcpy(DeviceChar, Device.c_str());
+	//all due DIO, ENC and ADC at once
+	Error = backend->readFrame(cycleADC, cycleENC, cycleDIO, readADC, readENC,
+			readDIO);
 
-	std::cout << "On device " << DeviceChar << "\n" << "On bus " << Bus << "\n"
-			<< "On slot " << Slot << "\n";
+	long long Read = ts->getNSecs();
+	stats[INTERFACE_STAGE_FRAME].record(Read - Begin);
 
-	s626 = s626_init("S626", DeviceChar);
+	//latest hardware scan
+	if (Error >= 0 && scanADC > 0) {
+		Scans = backend->readADCScan(readADC);
 
-	delete[] DeviceChar;
+		stats[INTERFACE_STAGE_SCAN].record(ts->getNSecs() - Read);
+	}
 
-	err = s626_set_options(s626);
-	if (err < 0) {
-		mutexCard.unlock();
-		return -2;
+	if (Error >= 0 && Scans >= 0)
+		cycleBacklog = backend->hasBacklog();
+
+	mutexCard.unlock();
+
+	//only recorded here, logged by a low priority thread
+	if (Error < 0 || Scans < 0) {
+		if (Error < 0) {
+			int Masks[BOARD_PERIPHERALS] = { cycleADC, 0, cycleENC, cycleDIO };
+
+			reportList(DIAG_CODE_READ_FRAME, Masks, Error);
+		} else
+			report(DIAG_CODE_READ_SCAN, BOARD_PERIPHERAL_ADC, -1, Scans);
+
+		failed();
+
+		cycleReady = false;
+		return;
 	}
 
-	err = s626_set_bus(s626, Bus);
-	if (err < 0) {
-		mutexCard.unlock();
-		return -3;
+	readFailures = 0;
+
+	acquired.timestamp = Timestamp;
+
+	acquired.ADCValid = cycleADC | (Scans > 0 ? cycleTable->scanADC : 0);
+	acquired.ENCValid = cycleENC;
+	acquired.DIOValid = cycleDIO;
+
+	//last good values are kept for channels not read
+	for (int i = 0; i < BOARD_ADC_CHANNELS; ++i)
+		if (acquired.ADCValid & (1 << i))
+			acquired.ADC[i] = readADC[i];
+
+	for (int i = 0; i < BOARD_ENC_CHANNELS; ++i)
+		if (cycleENC & (1 << i))
+			acquired.ENC[i] = readENC[i];
+
+	for (int i = 0; i < BOARD_DIO_BANKS; ++i)
+		if (cycleDIO & (1 << i))
+			acquired.DIO[i] = readDIO[i];
+}
+
+void Interface_thread::publishCycle(unsigned int Cycle) {
+	const Channel_table * Table = cycleTable;
+	unsigned int Seq;
+
+	if (!cycleReady) {
+		if (cycleStale)
+			publishStale(Cycle);
+
+		return;
 	}
 
-	err = s626_set_slot(s626, Slot);
-	if (err < 0) {
-		mutexCard.unlock();
-		return -4;
+	cycleReady = false;
+
+	//remember which frame produced each value
+	Seq = acquired.seq + 1;
+
+	for (int i = 0; i < Table->ADC.count; ++i)
+		if (acquired.ADCValid & (1 << Table->ADC.channel[i]))
+			acquired.ADCSeq[Table->ADC.channel[i]] = Seq;
+
+	for (int i = 0; i < Table->ENC.count; ++i)
+		if (acquired.ENCValid & (1 << Table->ENC.channel[i]))
+			acquired.ENCSeq[Table->ENC.channel[i]] = Seq;
+
+	for (int i = 0; i < Table->DIO.count; ++i)
+		if (acquired.DIOValid & (1 << Table->DIO.channel[i]))
+			acquired.DIOSeq[Table->DIO.channel[i]] = Seq;
+
+	//single publication of the whole frame
+	acquired.seq = Seq;
+	acquired.cycle = Cycle;
+	acquired.stale = 0;
+	frame.write(acquired);
+
+	if (acquired.DIOValid)
+		detectEdges();
+
+	//only a copy into the ring, the file is written by the recorder thread
+	Frame_recorder * Recorder = recorder;
+	if (Recorder)
+		Recorder->push(acquired);
+
+	//readers in other processes poll the segment
+	Frame_shm_writer * Shm = shm;
+	if (Shm)
+		Shm->publish(acquired);
+
+	fireTrigger();
+}
+
+void Interface_thread::publishStale(unsigned int Cycle) {
+	cycleStale = false;
+
+	//nothing to repeat before the first frame
+	if (acquired.seq == 0)
+		return;
+
+	++acquired.stale;
+	acquired.ADCValid = 0;
+	acquired.ENCValid = 0;
+	acquired.DIOValid = 0;
+
+	acquired.seq = acquired.seq + 1;
+	acquired.cycle = Cycle;
+	frame.write(acquired);
+
+	//recordings hold only read frames
+	Frame_shm_writer * Shm = shm;
+	if (Shm)
+		Shm->publish(acquired);
+
+	fireTrigger();
+}
+
+void Interface_thread::fireTrigger(void) {
+	triggering = 1;
+	__sync_synchronize();
+
+	RTT::base::ActivityInterface * Trigger = trigger;
+	if (Trigger)
+		Trigger->trigger();
+
+	__sync_synchronize();
+	triggering = 0;
+}
+
+void Interface_thread::failed(void) {
+	int Limit = watchdogLimit;
+
+	//recovery is requested again after every further Limit failures
+	if (Limit > 0 && ++readFailures % Limit == 0)
+		__sync_lock_test_and_set(&recoveryRequested, 1);
+
+	cycleStale = true;
+}
+
+void Interface_thread::setWatchdog(int Failures) {
+	watchdogLimit = Failures > 0 ? Failures : 0;
+}
+
+bool Interface_thread::takeRecoveryRequest(void) {
+	return __sync_lock_test_and_set(&recoveryRequested, 0) != 0;
+}
+
+void Interface_thread::detectEdges(void) {
+	S626_dio_edge Edge;
+	unsigned int Changed, Bits;
+	int Bank;
+
+	if (__sync_lock_test_and_set(&clearEdges, 0)) {
+		for (int i = 0; i < BOARD_DIO_BANKS; ++i)
+			for (int j = 0; j < 16; ++j)
+				risingDIO[i][j] = fallingDIO[i][j] = 0;
+
+		edgeValid = 0;
 	}
 
-	err = s626_open(s626);
+	for (int i = 0; i < cycleTable->DIO.count; ++i) {
+		Bank = cycleTable->DIO.channel[i];
 
-	if (err < 0) {
+		if (!(acquired.DIOValid & (1 << Bank)))
+			continue;
+
+		//the first read of a bank only sets the reference
+		if (!(edgeValid & (1 << Bank))) {
+			edgeDIO[Bank] = acquired.DIO[Bank];
+			edgeValid |= 1 << Bank;
+			continue;
+		}
+
+		//all 16 bits compared at once
+		Changed = (acquired.DIO[Bank] ^ edgeDIO[Bank]) & 0xFFFF;
+		if (Changed == 0)
+			continue;
+
+		edgeDIO[Bank] = acquired.DIO[Bank];
+
+		//only toggled bits are visited
+		Bits = Changed & acquired.DIO[Bank];
+		while (Bits) {
+			++risingDIO[Bank][__builtin_ctz(Bits)];
+			Bits &= Bits - 1;
+		}
+
+		Bits = Changed & ~acquired.DIO[Bank];
+		while (Bits) {
+			++fallingDIO[Bank][__builtin_ctz(Bits)];
+			Bits &= Bits - 1;
+		}
+
+		Edge.bank = Bank;
+		Edge.changed = Changed;
+		Edge.value = acquired.DIO[Bank] & 0xFFFF;
+		Edge.timestamp = acquired.timestamp;
+		Edge.seq = acquired.seq;
+
+		if (!edges.push(Edge))
+			++edgeOverflow;
+	}
+}
+
+bool Interface_thread::popEdge(S626_dio_edge & Edge) {
+	const S626_dio_edge * Front = edges.front();
+
+	if (Front == NULL)
+		return false;
+
+	Edge = *Front;
+	edges.pop();
+
+	return true;
+}
+
+void Interface_thread::getEdgeCounts(int Bank, unsigned int * Rising,
+		unsigned int * Falling) {
+	for (int i = 0; i < 16; ++i) {
+		Rising[i] = risingDIO[Bank][i];
+		Falling[i] = fallingDIO[Bank][i];
+	}
+}
+
+void Interface_thread::resetEdgeCounts(void) {
+	__sync_lock_test_and_set(&clearEdges, 1);
+}
+
+unsigned int Interface_thread::getEdgeOverflow(void) {
+	return edgeOverflow;
+}
+
+Waveform_player * Interface_thread::getWaveform(void) {
+	return &waveform;
+}
+
+int Interface_thread::resetDriver(std::string Device, int Bus, int Slot) {
+	int Error;
+
+	Error = stopDriver();
+
+	mutexCard.lock();
+
+	if (Error < 0) {
 		mutexCard.unlock();
-		return -5;
+		return -1;
 	}
 
+	std::cout << "On device " << Device << "\n" << "On bus " << Bus << "\n"
+			<< "On slot " << Slot << "\n";
+
+	Error = backend->open(Device, Bus, Slot);
+
+	//build the frame and restart the scan in the next cycle
+	frameADC = frameENC = frameDIO = -1;
+	scanADC = -1;
+	rangeADC = -1;
+
 	mutexCard.unlock();
 
+	if (Error < 0) {
+		report(DIAG_CODE_OPEN, DIAG_PERIPHERAL_BOARD, -1, Error);
+		return Error;
+	}
+
 	return 0;
 }
 
@@ -213,17 +620,14 @@ int Interface_thread::stopDriver(void) {
 
 	mutexCard.lock();
 
-	if (s626) {
-		err = s626_close(s626);
+	if (backend->isOpen()) {
+		int Error = backend->close();
 
-		if (err < 0) {
+		if (Error < 0) {
 			mutexCard.unlock();
+			report(DIAG_CODE_CLOSE, DIAG_PERIPHERAL_BOARD, -1, Error);
 			return -1;
 		}
-
-		s626_deinit(s626);
-
-		s626 = NULL;
 	}
 
 	mutexCard.unlock();
@@ -232,85 +636,140 @@ int Interface_thread::stopDriver(void) {
 }
 
 int Interface_thread::getDIO(int channel) {
-	mutexData.lock();
-	int tmp = DIO[channel];
-	mutexData.unlock();
-	return tmp;
+	S626_frame Frame;
+	frame.read(Frame);
+	return Frame.DIO[channel];
 }
 
 void Interface_thread::setDIO(int channel, int mask, int value) {
-	static int c_mask;
-	static int c_value;
-
+	unsigned int Staged, Merged;
+	unsigned int Mask = mask & 0xFFFF;
 
-	mutexConfig.lock();
-	c_mask = DIO_config[channel * 2];
-	c_value = DIO_config[channel * 2 + 1];
-	mutexConfig.unlock();
-
-	//mask is still the same
+	if (channel < 0 || channel >= BOARD_DIO_BANKS || Mask == 0)
+		return;
 
-	//clear only the bits which are affected
-	c_value = c_value & ~mask;
-	//set new value of the bits
-	c_value = (c_value | (value & mask)) & 0xFFFF;
+	//merge with the bits staged since the last flush
+	do {
+		Staged = stagedDIO[channel];
+		Merged = ((Staged | (Mask << 16)) & 0xFFFF0000u)
+				| (Staged & ~Mask & 0xFFFF) | (value & Mask);
+	} while (!__sync_bool_compare_and_swap(&stagedDIO[channel], Staged, Merged));
 
-	mutexConfig.lock();
-	DIO_config[channel * 2] = c_mask;
-	DIO_config[channel * 2 + 1] = c_value;
-	mutexConfig.unlock();
+	if ((Staged >> 16) & Mask)
+		__sync_fetch_and_add(&coalescedWrites, 1);
 
-	mutexCard.lock();
-	err = s626_dio_write(s626, channel + 2, c_mask, c_value);
-	mutexCard.unlock();
+	__sync_lock_test_and_set(&stagedOutputs, 1);
 }
 
 int Interface_thread::getADC(int channel) {
-	mutexData.lock();
-	int tmp = ADC[channel];
-	mutexData.unlock();
-	return tmp;
+	S626_frame Frame;
+	frame.read(Frame);
+	return Frame.ADC[channel];
 }
 
 void Interface_thread::setDAC(int channel, int value) {
-	char buffer[2];
+	if (channel < 0 || channel >= BOARD_DAC_CHANNELS)
+		return;
 
-	*(short int *) (&buffer[0]) = (short int) (value & 0xFFFF);
+	//latest value wins
+	if (__sync_lock_test_and_set(&stagedDAC[channel],
+			INTERFACE_OUTPUT_STAGED | (value & 0xFFFF)) & INTERFACE_OUTPUT_STAGED)
+		__sync_fetch_and_add(&coalescedWrites, 1);
 
-	mutexCard.lock();
-	err = s626_dac_write(s626, 1, channel, &buffer[0]);
+	__sync_lock_test_and_set(&stagedOutputs, 1);
+}
+
+void Interface_thread::flushOutputs(const Channel_table * Table) {
+	int DACMask = 0, DIOMask = 0;
+	int DAC[BOARD_DAC_CHANNELS];
+	unsigned int Staged;
+
+	if (!stagedOutputs)
+		return;
+
+	//outputs stay staged while the card is busy or closed
+	if (!mutexCard.trylock())
+		return;
+
+	if (!backend->isOpen()) {
+		mutexCard.unlock();
+		return;
+	}
+
+	if (!__sync_lock_test_and_set(&stagedOutputs, 0)) {
+		mutexCard.unlock();
+		return;
+	}
+
+	for (int i = 0; i < BOARD_DAC_CHANNELS; ++i) {
+		Staged = __sync_lock_test_and_set(&stagedDAC[i], 0);
+		if (Staged & INTERFACE_OUTPUT_STAGED) {
+			DAC[i] = Staged & 0xFFFF;
+			DACMask |= 1 << i;
+		}
+	}
+
+	for (int i = 0; i < BOARD_DIO_BANKS; ++i) {
+		Staged = __sync_lock_test_and_set(&stagedDIO[i], 0);
+		if (Staged) {
+			//clear only the bits which are affected and set their new value
+			outputDIO[i] = (outputDIO[i] & ~(Staged >> 16))
+					| (Staged & (Staged >> 16) & 0xFFFF);
+			DIOMask |= 1 << i;
+		}
+	}
+
+	if (DACMask == 0 && DIOMask == 0) {
+		mutexCard.unlock();
+		return;
+	}
+
+	int Error = backend->writeOutputs(DACMask, DAC, DIOMask, Table->outputDIO,
+			outputDIO);
 	mutexCard.unlock();
+
+	if (Error < 0) {
+		int Masks[BOARD_PERIPHERALS] = { 0, DACMask, 0, DIOMask };
+
+		reportList(DIAG_CODE_WRITE_OUTPUTS, Masks, Error);
+	}
 }
 
 int Interface_thread::getENC(int channel) {
-	mutexData.lock();
-	int tmp = ENC[channel];
-	mutexData.unlock();
-	return tmp;
+	S626_frame Frame;
+	frame.read(Frame);
+	return Frame.ENC[channel];
+}
+
+void Interface_thread::getFrame(S626_frame & Frame) {
+	frame.read(Frame);
 }
 
 void Interface_thread::setrangeADC(int mask, int value) {
-	mutexCard.lock();
-	s626_adc_set_range(s626, mask, value);
-	mutexCard.unlock();
+	mutexConfig.lock();
+	ADC_range = ((ADC_range & ~mask) | (value & mask)) & 0xFFFF;
+	compile();
+	mutexConfig.unlock();
 }
 
 int Interface_thread::prepareENC(void) {
 
 	mutexCard.lock();
-	if (s626) {
+	if (backend->isOpen()) {
 		mutexCard.unlock();
 		for (int i = 0; i < 6; ++i) {
 			mutexCard.lock();
-			s626_gpct_conf_enc(s626, 5, i);
+			int Error = backend->configureENC(i);
 			mutexCard.unlock();
-			mutexData.lock();
-			ENC[i] = 0;
-			mutexData.unlock();
+
+			if (Error < 0)
+				report(DIAG_CODE_CONFIGURE_ENC, BOARD_PERIPHERAL_ENC, i, Error);
 		}
+
+		clearENC = 1;
 	} else {
 		mutexCard.unlock();
-		err = -100;
+		report(DIAG_CODE_NOT_OPEN, BOARD_PERIPHERAL_ENC, -1, -ENODEV);
 		return -1;
 	}
 
@@ -318,36 +777,298 @@ int Interface_thread::prepareENC(void) {
 }
 
 void Interface_thread::setActivePublishing(int state) {
-	mutexActivity.lock();
+	mutexConfig.lock();
 	this->state = state;
-	mutexActivity.unlock();
+	compile();
+	mutexConfig.unlock();
 }
 
 void Interface_thread::setInitialDIO( std::vector<int> InitialDIO) {
-	mutexData.lock();
+	mutexConfig.lock();
 	for(int i = 0; i < 6; ++i)
 		DIO_config[i] = InitialDIO[i] & 0xFFFF;
-	mutexData.unlock();
+	compile();
+	mutexConfig.unlock();
 
-	mutexConfig.lock();
-	mutexCard.lock();
+	//all the bits of each bank are written in the next cycle
 	for( int i = 0; i < 3; ++i)
-	{
-		err = s626_dio_write(s626, i + 2,
-				DIO_config[i*2] & 0xFFFF, DIO_config[i*2+1] & 0xFFFF);
-	}
-	mutexCard.unlock();
-	mutexConfig.unlock();
+		setDIO(i, 0xFFFF, DIO_config[i*2+1]);
 }
 
 void Interface_thread::setInitialADC( int InitialADC) {
 	mutexConfig.lock();
 	ADC_config = InitialADC;
+	compile();
 	mutexConfig.unlock();
 }
 
 void Interface_thread::setInitialENC( int InitialENC) {
 	mutexConfig.lock();
 	ENC_config = InitialENC;
+	compile();
+	mutexConfig.unlock();
+}
+
+int Interface_thread::setBackend(Board_backend * Backend) {
+	if (Backend == NULL)
+		return -1;
+
+	if (stopDriver() < 0) {
+		delete Backend;
+		return -2;
+	}
+
+	mutexCard.lock();
+	delete backend;
+	backend = Backend;
+	frameADC = frameENC = frameDIO = -1;
+	scanADC = -1;
+	rangeADC = -1;
+	mutexCard.unlock();
+
+	return 0;
+}
+
+Board_backend * Interface_thread::getBackend(void) {
+	return backend;
+}
+
+void Interface_thread::setADCMode(int Mode, double Period) {
+	mutexConfig.lock();
+	ADC_mode = Mode;
+	if (Period > 0.0)
+		ADC_scan_period = (int) (Period * 1e9);
+	compile();
+	mutexConfig.unlock();
+}
+
+void Interface_thread::getCycleStats(S626_cycle_stats & Stats) {
+	Stats.period = cyclePeriod > 0 ? cyclePeriod : getPeriodNS();
+	Stats.deadlineMisses = deadlineMisses;
+
+	stats[INTERFACE_STAGE_WAKEUP].summary(Stats.wakeup);
+	stats[INTERFACE_STAGE_FRAME].summary(Stats.frame);
+	stats[INTERFACE_STAGE_SCAN].summary(Stats.scan);
+	stats[INTERFACE_STAGE_STEP].summary(Stats.step);
+}
+
+long long Interface_thread::getCyclePercentile(int Stage, double Percentile) {
+	if (Stage < 0 || Stage >= INTERFACE_STAGES)
+		return -1;
+
+	return stats[Stage].percentile(Percentile);
+}
+
+unsigned int Interface_thread::getCoalescedWrites(void) {
+	return coalescedWrites;
+}
+
+void Interface_thread::resetCycleStats(void) {
+	for (int i = 0; i < INTERFACE_STAGES; ++i)
+		stats[i].reset();
+
+	resetMisses = 1;
+}
+
+void Interface_thread::setRecorder(Frame_recorder * Recorder) {
+	recorder = Recorder;
+}
+
+void Interface_thread::setSharedMemory(Frame_shm_writer * Writer) {
+	shm = Writer;
+}
+
+void Interface_thread::setDiagLog(Diag_log * Log) {
+	diag = Log;
+}
+
+void Interface_thread::report(int Code, int Peripheral, int Channel,
+		int Error) {
+	Diag_log * Log = diag;
+
+	if (Log)
+		Log->report(Code, Peripheral, Channel, Error);
+}
+
+void Interface_thread::reportList(int Code, const int * Masks, int Error) {
+	bool Reported = false;
+
+	for (int i = 0; i < BOARD_PERIPHERALS; ++i) {
+		int Channel = -1;
+
+		if (Masks[i] == 0)
+			continue;
+
+		//single channel lists name the channel
+		if ((Masks[i] & (Masks[i] - 1)) == 0)
+			for (Channel = 0; !(Masks[i] & (1 << Channel)); ++Channel)
+				;
+
+		report(Code, i, Channel, Error);
+		Reported = true;
+	}
+
+	if (!Reported)
+		report(Code, DIAG_PERIPHERAL_BOARD, -1, Error);
+}
+
+void Interface_thread::setTrigger(RTT::base::ActivityInterface * Activity) {
+	trigger = Activity;
+
+	//the cycle may have loaded the previous activity already
+	__sync_synchronize();
+	while (triggering)
+		usleep(100);
+}
+
+void Interface_thread::acknowledge(unsigned int Seq) {
+	acknowledged = Seq;
+}
+
+bool Interface_thread::setCyclePeriod(double Period) {
+	if (Period <= 0.0)
+		return false;
+
+	if (!setPeriod(Period))
+		return false;
+
+	resyncWakeup = 1;
+
+	return true;
+}
+
+double Interface_thread::getAchievableRate(void) {
+	long long Step = stats[INTERFACE_STAGE_STEP].percentile(99.0);
+
+	if (Step <= 0)
+		return 0.0;
+
+	return 1e9 / (double) Step;
+}
+
+int Interface_thread::due(unsigned int Cycle, const Channel_list & List) {
+	int Due = 0;
+
+	for (int i = 0; i < List.count; ++i) {
+		if (List.divider[i] == 1 || (int) (Cycle % List.divider[i]) == List.phase[i])
+			Due |= 1 << List.channel[i];
+	}
+
+	return Due;
+}
+
+void Interface_thread::compileList(Channel_list & List, int Mask, int Count,
+		const int * Divider, const int * Phase) {
+	List.count = 0;
+	List.mask = 0;
+
+	for (int i = 0; i < Count; ++i) {
+		if (Mask & (1 << i)) {
+			List.channel[List.count] = i;
+			List.divider[List.count] = Divider[i];
+			List.phase[List.count] = Phase[i];
+			++List.count;
+
+			List.mask |= 1 << i;
+		}
+	}
+}
+
+void Interface_thread::compile(void) {
+	int ADCMask = 0, ENCMask = 0, DIOMask = 0;
+	Channel_table * Table = tables.prepare();
+
+	if (state > 0) {
+		if (INTERFACE_ACTIVITY_MASK_ADC & state)
+			ADCMask = ADC_config & 0xFFFF;
+		if (INTERFACE_ACTIVITY_MASK_ENC & state)
+			ENCMask = ENC_config & 0x3F;
+		if (INTERFACE_ACTIVITY_MASK_DIO & state)
+			DIOMask = 0x07;
+	}
+
+	//ADC are not converted in the frame but scanned by the board
+	Table->scanADC = 0;
+	if (ADC_mode == INTERFACE_ADC_MODE_SCAN) {
+		Table->scanADC = ADCMask;
+		ADCMask = 0;
+	}
+	Table->scanPeriod = ADC_scan_period;
+
+	schedule(ADCMask, ENCMask, DIOMask);
+
+	compileList(Table->ADC, ADCMask, BOARD_ADC_CHANNELS, ADC_divider, ADC_phase);
+	compileList(Table->ENC, ENCMask, BOARD_ENC_CHANNELS, ENC_divider, ENC_phase);
+	compileList(Table->DIO, DIOMask, BOARD_DIO_BANKS, DIO_divider, DIO_phase);
+
+	Table->rangeADC = ADC_range;
+
+	for (int i = 0; i < BOARD_DIO_BANKS; ++i)
+		Table->outputDIO[i] = DIO_config[i * 2] & 0xFFFF;
+
+	++Table->generation;
+	tables.publish(Table);
+}
+
+int Interface_thread::nextPhase(int * Dividers, int & Count, int Divider) {
+	int Phase = 0;
+
+	for (int i = 0; i < Count; ++i)
+		if (Dividers[i] == Divider)
+			++Phase;
+
+	Dividers[Count++] = Divider;
+
+	return Phase % Divider;
+}
+
+void Interface_thread::schedule(int ADCMask, int ENCMask, int DIOMask) {
+	//next phase for each divider, only the channels read in
+	//the frame are spread round robin over the cycles
+	int Dividers[BOARD_ADC_CHANNELS + BOARD_ENC_CHANNELS + BOARD_DIO_BANKS];
+	int Count = 0;
+
+	for (int i = 0; i < BOARD_ADC_CHANNELS; ++i)
+		ADC_phase[i] = (ADCMask & (1 << i)) ?
+				nextPhase(Dividers, Count, ADC_divider[i]) : 0;
+
+	for (int i = 0; i < BOARD_ENC_CHANNELS; ++i)
+		ENC_phase[i] = (ENCMask & (1 << i)) ?
+				nextPhase(Dividers, Count, ENC_divider[i]) : 0;
+
+	for (int i = 0; i < BOARD_DIO_BANKS; ++i)
+		DIO_phase[i] = (DIOMask & (1 << i)) ?
+				nextPhase(Dividers, Count, DIO_divider[i]) : 0;
+}
+
+void Interface_thread::setRateDivider(int Peripheral, int Mask, int Divider) {
+	int * Dividers;
+	int Count;
+
+	if (Divider < 1)
+		Divider = 1;
+
+	switch (Peripheral) {
+	case BOARD_PERIPHERAL_ADC:
+		Dividers = ADC_divider;
+		Count = BOARD_ADC_CHANNELS;
+		break;
+	case BOARD_PERIPHERAL_ENC:
+		Dividers = ENC_divider;
+		Count = BOARD_ENC_CHANNELS;
+		break;
+	case BOARD_PERIPHERAL_DIO:
+		Dividers = DIO_divider;
+		Count = BOARD_DIO_BANKS;
+		break;
+	default:
+		return;
+	}
+
+	mutexConfig.lock();
+	for (int i = 0; i < Count; ++i)
+		if (Mask & (1 << i))
+			Dividers[i] = Divider;
+	compile();
 	mutexConfig.unlock();
 }
@@ -34,31 +34,98 @@
 #include <rtt/os/main.h>
 #include <rtt/os/Mutex.hpp>
 #include <rtt/os/Thread.hpp>
-
-#include "S626API.h"
+#include <rtt/base/ActivityInterface.hpp>
+
+#include "Aligned-alloc.hpp"
+#include "Board-backend.hpp"
+#include "Seqlock.hpp"
+#include "s626_task-types.hpp"
+#include "Cycle-stats.hpp"
+#include "Channel-table.hpp"
+#include "Frame-recorder.hpp"
+#include "Frame-shm.hpp"
+#include "Diag-log.hpp"
+#include "Spsc-ring.hpp"
+#include "Waveform-player.hpp"
 
 #define INTERFACE_ACTIVITY_MASK_ADC 0x01
 #define INTERFACE_ACTIVITY_MASK_ENC 0x02
 #define INTERFACE_ACTIVITY_MASK_DIO 0x04
 
-class Interface_thread: public RTT::os::Thread {
+#define INTERFACE_ADC_MODE_SYNC 0
+#define INTERFACE_ADC_MODE_SCAN 1
+
+#define INTERFACE_STAGE_WAKEUP 0
+#define INTERFACE_STAGE_FRAME 1
+#define INTERFACE_STAGE_SCAN 2
+#define INTERFACE_STAGE_STEP 3
+#define INTERFACE_STAGES 4
+
+#define INTERFACE_OUTPUT_STAGED 0x80000000u
+
+/**
+ * DIO edge events kept until the component publishes them
+ */
+#define INTERFACE_EDGE_RING_SIZE 256
+
+/**
+ * Share of the period in percent the thread may spend reading
+ * frames of a backend with backlog
+ */
+#define INTERFACE_BACKLOG_SHARE 80
+
+/**
+ * Time in ns the thread sleeps while the triggered consumer
+ * has not acknowledged a frame of a backend with backlog
+ */
+#define INTERFACE_BACKLOG_POLL 20000
+
+class Interface_thread: public RTT::os::Thread, public Aligned_alloc {
 public:
 
 	Interface_thread(int scheduler, int priority, double period,
 			unsigned int cpu_affinity, std::string name);
 
+	~Interface_thread();
+
+	bool initialize(void);
+
 	void step(void);
 
 	int getDIO(int channel);
 
+	/**
+	 * \brief setDIO
+	 *
+	 * Stages new value of the bits selected by mask. Writes to
+	 * the same bank are merged until the next cycle of the thread,
+	 * which writes all the staged outputs at once.
+	 */
 	void setDIO( int channel, int mask, int value);
 
 	int getADC(int channel);
 
+	/**
+	 * \brief setDAC
+	 *
+	 * Stages new value of the channel, only the latest value
+	 * staged before the next cycle of the thread is written.
+	 */
 	void setDAC( int channel, int value);
 
 	int getENC(int channel);
 
+	/**
+	 * \brief getFrame
+	 *
+	 * Copies coherent snapshot of all the peripherals
+	 * acquired during the last cycle. Never blocks the
+	 * acquisition.
+	 *
+	 * \param[out]	Frame		Last acquired frame
+	 */
+	void getFrame(S626_frame & Frame);
+
 	void setrangeADC( int mask, int value);
 
 	int prepareENC(void);
@@ -67,6 +134,27 @@ public:
 
 	int stopDriver(void);
 
+	/**
+	 * \brief setBackend
+	 *
+	 * Replaces the board backend. The previous backend
+	 * is closed and deleted.
+	 *
+	 * \param[in]	Backend		New backend, the thread takes its ownership
+	 *
+	 * \return		0					When the backend was replaced
+	 * 						!=0				Otherwise, the Backend is deleted
+	 */
+	int setBackend(Board_backend * Backend);
+
+	/**
+	 * \brief getBackend
+	 *
+	 * \return		Currently used backend. It stays valid until
+	 * 						next \link setBackend setBackend \endlink
+	 */
+	Board_backend * getBackend(void);
+
   /**
    * \brief setActivePublishing
    *
@@ -121,31 +209,548 @@ public:
    */
   void setInitialENC( int InitialENC);
 
+  /**
+   * \brief setADCMode
+   *
+   * Selects how ADC channels are acquired.
+   *
+   * \param[in]	Mode			INTERFACE_ADC_MODE_SYNC converts every channel
+   * 											on demand in each cycle,
+   * 											INTERFACE_ADC_MODE_SCAN lets the board scan
+   * 											the channels with its own timer and
+   * 											each cycle takes the latest complete scan
+   * \param[in]	Period		Time between hardware scans in seconds,
+   * 											used only by INTERFACE_ADC_MODE_SCAN
+   */
+  void setADCMode( int Mode, double Period);
+
+  /**
+   * \brief getCycleStats
+   *
+   * Summarizes timing of the cycles recorded since
+   * the last reset. Does not block the thread.
+   *
+   * \param[out]	Stats		Histogram summaries of all stages
+   */
+  void getCycleStats( S626_cycle_stats & Stats);
+
+  /**
+   * \brief getCyclePercentile
+   *
+   * \param[in]	Stage				INTERFACE_STAGE_WAKEUP, INTERFACE_STAGE_FRAME,
+   * 												INTERFACE_STAGE_SCAN or INTERFACE_STAGE_STEP
+   * \param[in]	Percentile	Value from 0 to 100
+   *
+   * \return		Percentile of the stage duration in nanoseconds
+   */
+  long long getCyclePercentile( int Stage, double Percentile);
+
+  /**
+   * \brief resetCycleStats
+   *
+   * Clears all histograms and deadline miss counter.
+   * The clearing is done by the thread itself in the
+   * next cycle.
+   */
+  void resetCycleStats( void);
+
+  /**
+   * \brief getCoalescedWrites
+   *
+   * \return		Number of DAC and DIO writes superseded
+   * 						by a newer one before reaching the board
+   */
+  unsigned int getCoalescedWrites( void);
+
+  /**
+   * \brief setTrigger
+   *
+   * Sets activity triggered right after every published frame.
+   * Returns only after a trigger of the previous activity which
+   * is in progress has finished, so it is not triggered anymore.
+   *
+   * \param[in]	Activity		Non periodic activity of the consumer,
+   * 												NULL disables triggering
+   */
+  void setTrigger( RTT::base::ActivityInterface * Activity);
+
+  /**
+   * \brief acknowledge
+   *
+   * Called by the triggered consumer when it took the frame.
+   * Frames of a backend with backlog are read only as fast as
+   * the consumer acknowledges them, so none of them is skipped.
+   * Without a trigger nobody acknowledges and intermediate frames
+   * are overwritten before a periodic consumer reads them.
+   *
+   * \param[in]	Seq		Sequence number of the consumed frame
+   */
+  void acknowledge( unsigned int Seq);
+
+  /**
+   * \brief setCyclePeriod
+   *
+   * Changes the period of the running thread.
+   * The ideal release used for the wake-up latency is
+   * resynchronized in the next cycle.
+   *
+   * \param[in]	Period		Period in seconds
+   */
+  bool setCyclePeriod( double Period);
+
+  /**
+   * \brief getAchievableRate
+   *
+   * Estimates maximal rate of the thread from the
+   * 99th percentile of the measured step duration.
+   *
+   * \return		Rate in Hz, 0 when nothing was measured yet
+   */
+  double getAchievableRate( void);
+
+  /**
+   * \brief setRateDivider
+   *
+   * Reads selected channels only every Divider-th cycle.
+   * Phases of channels with the same divider are spread
+   * over the cycles to flatten the worst case cycle time.
+   *
+   * \param[in]	Peripheral	BOARD_PERIPHERAL_ADC, BOARD_PERIPHERAL_ENC
+   * 											or BOARD_PERIPHERAL_DIO
+   * \param[in]	Mask				Channels or banks affected
+   * \param[in]	Divider			1 reads in every cycle
+   */
+  void setRateDivider( int Peripheral, int Mask, int Divider);
+
+  /**
+   * \brief startCycle
+   *
+   * Records wake-up latency of the cycle. Together with
+   * prepareCycle, readCycle, publishCycle and finishCycle it lets
+   * an Acquisition_engine drive the board instead of the own thread,
+   * all of them are called only by the thread running the cycle.
+   *
+   * \param[in]	Start			Time the cycle was released in nanoseconds
+   * \param[in]	Period		Period of the cycle in nanoseconds
+   */
+  void startCycle( long long Start, long long Period);
+
+  /**
+   * \brief prepareCycle
+   *
+   * Writes staged outputs, takes the channel table and
+   * reconfigures the board when it changed.
+   *
+   * \return		true when the board has to be read in this cycle
+   */
+  bool prepareCycle( void);
+
+  /**
+   * \brief readCycle
+   *
+   * Reads the channels due in the cycle with a single batched read.
+   *
+   * \param[in]	Timestamp		Timestamp of the frame in nanoseconds
+   */
+  void readCycle( long long Timestamp);
+
+  /**
+   * \brief publishCycle
+   *
+   * Publishes the frame read in the cycle and triggers the consumer.
+   * When the board could not be read the last frame is published
+   * again marked as stale.
+   *
+   * \param[in]	Cycle		Number of the cycle stored in the frame
+   */
+  void publishCycle( unsigned int Cycle);
+
+  /**
+   * \brief finishCycle
+   *
+   * Records duration of the cycle and deadline misses.
+   */
+  void finishCycle( long long Start, long long End, long long Period);
+
+  /**
+   * \brief setRecorder
+   *
+   * \param[in]	Recorder		Recorder receiving every published frame,
+   * 											NULL disables it. It has to outlive the thread.
+   */
+  void setRecorder( Frame_recorder * Recorder);
+
+  /**
+   * \brief setSharedMemory
+   *
+   * \param[in]	Writer		Shared memory segment receiving every published
+   * 										frame, NULL disables it. It has to outlive the thread.
+   */
+  void setSharedMemory( Frame_shm_writer * Writer);
+
+  /**
+   * \brief setDiagLog
+   *
+   * \param[in]	Log		Log receiving failures of the board, NULL
+   * 								disables reporting. It has to outlive the thread.
+   */
+  void setDiagLog( Diag_log * Log);
+
+  /**
+   * \brief setWatchdog
+   *
+   * \param[in]	Failures		Number of consecutive failed cycles after
+   * 											which recovery of the board is requested,
+   * 											0 disables the watchdog
+   */
+  void setWatchdog( int Failures);
+
+  /**
+   * \brief takeRecoveryRequest
+   *
+   * \return		true when the watchdog requested recovery
+   * 						since the last call
+   */
+  bool takeRecoveryRequest( void);
+
+  /**
+   * \brief popEdge
+   *
+   * Takes the oldest DIO edge event. Called by a single consumer.
+   *
+   * \return		false when there is no event
+   */
+  bool popEdge( S626_dio_edge & Edge);
+
+  /**
+   * \brief getEdgeCounts
+   *
+   * Copies edge counters of every bit of the bank.
+   *
+   * \param[in]	Bank			Bank number 0-2
+   * \param[out]	Rising		16 counters of rising edges
+   * \param[out]	Falling		16 counters of falling edges
+   */
+  void getEdgeCounts( int Bank, unsigned int * Rising, unsigned int * Falling);
+
+  /**
+   * \brief resetEdgeCounts
+   *
+   * Clears edge counters in the next cycle, the value read
+   * in that cycle becomes the reference for further edges.
+   */
+  void resetEdgeCounts( void);
+
+  /**
+   * \brief getEdgeOverflow
+   *
+   * \return		Number of edge events lost because
+   * 						the consumer did not take them
+   */
+  unsigned int getEdgeOverflow( void);
+
+  /**
+   * \brief getWaveform
+   *
+   * \return		Waveform player whose samples are written
+   * 						to the DAC every cycle of the thread
+   */
+  Waveform_player * getWaveform( void);
+
 private:
 
+	/**
+	 * \brief schedule
+	 *
+	 * Computes phases of the enabled channels from their dividers,
+	 * channels sharing a divider get consecutive phases.
+	 * Called by compile with mutexConfig held.
+	 */
+	void schedule(int ADCMask, int ENCMask, int DIOMask);
+
+	/**
+	 * Appends Divider to the dividers already scheduled
+	 *
+	 * \return		Next phase of the channels sharing Divider
+	 */
+	static int nextPhase(int * Dividers, int & Count, int Divider);
+
+	/**
+	 * \brief compile
+	 *
+	 * Builds channel table from the configuration and publishes it,
+	 * the thread uses it from the next cycle. Called with mutexConfig held.
+	 */
+	void compile(void);
+
+	/**
+	 * Fills the list with the channels enabled by Mask
+	 */
+	static void compileList(Channel_list & List, int Mask, int Count,
+			const int * Divider, const int * Phase);
+
+	/**
+	 * Mask of channels due in the cycle
+	 */
+	static int due(unsigned int Cycle, const Channel_list & List);
+
+	/**
+	 * \brief acquire
+	 *
+	 * Reads the selected peripherals and publishes the frame.
+	 * While the backend has backlog further frames are read
+	 * within the same period.
+	 */
+	void acquire(void);
+
+	/**
+	 * Writes the outputs staged since the last cycle
+	 */
+	void flushOutputs(const Channel_table * Table);
+
+	/**
+	 * Compares DIO banks read in the cycle with their previous
+	 * values, counts edges and queues edge events
+	 */
+	void detectEdges(void);
+
+	/**
+	 * Passes the failure to the diagnostic log, never blocks
+	 */
+	void report(int Code, int Peripheral, int Channel, int Error);
+
+	/**
+	 * Reports a failure of an instruction list against every
+	 * peripheral it contained, the channel is given only when
+	 * the list held a single channel of the peripheral. The
+	 * driver fails the list as a whole, so the failing
+	 * instruction itself is not known.
+	 */
+	void reportList(int Code, const int * Masks, int Error);
+
+	/**
+	 * Republishes the last frame when the board could not be read
+	 */
+	void publishStale(unsigned int Cycle);
+
+	/**
+	 * Triggers the consumer, setTrigger waits until it returns
+	 */
+	void fireTrigger(void);
+
+	/**
+	 * Counts a failed cycle for the watchdog
+	 */
+	void failed(void);
+
 	int runLoop;
 
 	RTT::os::Mutex mutexCard;
-	RTT::os::Mutex mutexData;
-	RTT::os::Mutex mutexActivity;
 	RTT::os::Mutex mutexConfig;
 
-	ts626 * s626;
+	Board_backend * backend;
 
-	int err;
+	/**
+	 * Frame being acquired, owned by the thread
+	 */
+	S626_frame acquired;
 
-	int DIO[3];
+	/**
+	 * Values read in the cycle, taken into acquired only when
+	 * the whole read succeeded
+	 */
+	int readADC[BOARD_ADC_CHANNELS];
 
-	int ADC[16];
+	int readENC[BOARD_ENC_CHANNELS];
 
-	int ENC[6];
+	int readDIO[BOARD_DIO_BANKS];
+
+	/**
+	 * Last complete frame published to readers
+	 */
+	Seqlock<S626_frame> frame;
+
+	/**
+	 * Requests to clear encoder values in the next cycle
+	 */
+	volatile int clearENC;
 
 	int DIO_config[6];
 
+	/**
+	 * Staged DAC values, INTERFACE_OUTPUT_STAGED marks a pending write
+	 */
+	volatile unsigned int stagedDAC[BOARD_DAC_CHANNELS];
+
+	/**
+	 * Staged DIO writes, changed bits in the upper
+	 * half and their values in the lower half
+	 */
+	volatile unsigned int stagedDIO[BOARD_DIO_BANKS];
+
+	/**
+	 * Set when any output is staged
+	 */
+	volatile int stagedOutputs;
+
+	/**
+	 * Values of DIO outputs, owned by the thread
+	 */
+	int outputDIO[BOARD_DIO_BANKS];
+
+	/**
+	 * Number of staged writes superseded before being flushed
+	 */
+	volatile unsigned int coalescedWrites;
+
 	int ADC_config;
 
 	int ENC_config;
 
+	/**
+	 * Range of ADC channels, bit set for +/- 10 V
+	 */
+	int ADC_range;
+
+	/**
+	 * Compiled configuration used by the acquisition loop
+	 */
+	Channel_tables tables;
+
+	/**
+	 * ADC range applied to the backend, -1 forces update
+	 */
+	int rangeADC;
+
+	/**
+	 * Channels the backend frame is configured for,
+	 * -1 forces reconfiguration
+	 */
+	int frameADC;
+
+	int frameENC;
+
+	int frameDIO;
+
+	int ADC_divider[BOARD_ADC_CHANNELS];
+	int ENC_divider[BOARD_ENC_CHANNELS];
+	int DIO_divider[BOARD_DIO_BANKS];
+
+	int ADC_phase[BOARD_ADC_CHANNELS];
+	int ENC_phase[BOARD_ENC_CHANNELS];
+	int DIO_phase[BOARD_DIO_BANKS];
+
+	/**
+	 * Cycle counter used by dividers
+	 */
+	unsigned int tick;
+
+	int ADC_mode;
+
+	/**
+	 * Hardware scan period in nanoseconds
+	 */
+	int ADC_scan_period;
+
+	/**
+	 * Channels and period of the running scan,
+	 * -1 forces restart
+	 */
+	int scanADC;
+
+	int scanPeriod;
+
+	/**
+	 * State of the cycle between prepareCycle and publishCycle
+	 */
+	const Channel_table * cycleTable;
+
+	bool cycleReady;
+
+	/**
+	 * Set when the board could not be read in the cycle
+	 */
+	bool cycleStale;
+
+	/**
+	 * Set when the backend had another frame ready after the read
+	 */
+	bool cycleBacklog;
+
+	volatile unsigned int acknowledged;
+
+	int cycleADC;
+
+	int cycleENC;
+
+	int cycleDIO;
+
+	/**
+	 * Histograms of the stages indexed by INTERFACE_STAGE_*
+	 */
+	Cycle_histogram stats[INTERFACE_STAGES];
+
+	volatile unsigned int deadlineMisses;
+
+	volatile int resetMisses;
+
+	volatile int resyncWakeup;
+
+	/**
+	 * Ideal release time of the next cycle, 0 when unknown
+	 */
+	long long nextWakeup;
+
+	/**
+	 * Period of the last cycle, given by the thread or the engine
+	 */
+	volatile long long cyclePeriod;
+
+	RTT::base::ActivityInterface * volatile trigger;
+
+	/**
+	 * Set while the thread triggers the consumer
+	 */
+	volatile int triggering;
+
+	Frame_recorder * volatile recorder;
+
+	Frame_shm_writer * volatile shm;
+
+	Diag_log * volatile diag;
+
+	/**
+	 * Consecutive failed cycles, owned by the thread
+	 */
+	unsigned int readFailures;
+
+	volatile int watchdogLimit;
+
+	volatile int recoveryRequested;
+
+	/**
+	 * Previous values of DIO banks, valid for banks in edgeValid,
+	 * owned by the thread
+	 */
+	int edgeDIO[BOARD_DIO_BANKS];
+
+	int edgeValid;
+
+	/**
+	 * Requests to clear edge counters in the next cycle
+	 */
+	volatile int clearEdges;
+
+	volatile unsigned int risingDIO[BOARD_DIO_BANKS][16];
+
+	volatile unsigned int fallingDIO[BOARD_DIO_BANKS][16];
+
+	volatile unsigned int edgeOverflow;
+
+	Spsc_ring<S626_dio_edge, INTERFACE_EDGE_RING_SIZE> edges;
+
+	Waveform_player waveform;
+
 	int state;
 
 };
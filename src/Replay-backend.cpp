@@ -0,0 +1,328 @@
+/**
+ * \file Replay-backend.cpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include "Replay-backend.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#include <rtt/os/TimeService.hpp>
+
+#define REPLAY_RESTART_TIME 1
+#define REPLAY_RESTART_REWIND 2
+
+Replay_backend::Replay_backend() :
+		offset(0), opened(false), finished(false), restart(0), ahead(false), replayed(
+				0), mode(REPLAY_MODE_REALTIME), speed(1.0), startTime(0), startRecorded(
+				0), captured(0), overflow(0), adcRange(0) {
+	memset(&current, 0, sizeof(current));
+	memset(&following, 0, sizeof(following));
+}
+
+int Replay_backend::open(std::string Device, int /* Bus */, int /* Slot */) {
+	Record_header Header;
+	FILE * File;
+
+	close();
+
+	File = fopen(Device.c_str(), "rb");
+	if (File == NULL)
+		return -5;
+
+	if (fread(&Header, sizeof(Header), 1, File) != 1
+			|| !checkRecordHeader(Header) || fseek(File, Header.size, SEEK_SET) != 0) {
+		fclose(File);
+		return -5;
+	}
+
+	data.resize(Header.used);
+	if (Header.used > 0 && fread(&data[0], Header.used, 1, File) != 1) {
+		data.clear();
+		fclose(File);
+		return -5;
+	}
+
+	fclose(File);
+
+	//capture is allocated here, not while replaying
+	captures.resize(REPLAY_CAPTURE_SIZE);
+
+	offset = 0;
+	ahead = false;
+	memset(&current, 0, sizeof(current));
+	finished = false;
+	restart = 0;
+	replayed = 0;
+	startTime = 0;
+	captured = 0;
+	overflow = 0;
+
+	opened = true;
+
+	return 0;
+}
+
+int Replay_backend::close(void) {
+	opened = false;
+
+	return 0;
+}
+
+bool Replay_backend::isOpen(void) {
+	return opened;
+}
+
+int Replay_backend::readDIO(int bank, int * value) {
+	*value = current.DIO[bank];
+
+	return 0;
+}
+
+int Replay_backend::writeDIO(int bank, int mask, int value) {
+	capture(REPLAY_CAPTURE_DIO, bank, mask, value);
+
+	return 0;
+}
+
+int Replay_backend::readADC(int channel, int * value) {
+	*value = current.ADC[channel];
+
+	return 0;
+}
+
+void Replay_backend::setrangeADC(int mask, int value) {
+	//recorded values are raw, range only affects their interpretation
+	adcRange = (adcRange & ~mask) | (value & mask);
+}
+
+int Replay_backend::writeDAC(int channel, int value) {
+	capture(REPLAY_CAPTURE_DAC, channel, 0xFFFF, value);
+
+	return 0;
+}
+
+int Replay_backend::configureENC(int /* channel */) {
+	return 0;
+}
+
+int Replay_backend::readENC(int channel, int * value) {
+	*value = current.ENC[channel];
+
+	return 0;
+}
+
+int Replay_backend::readFrame(int ADCMask, int ENCMask, int DIOMask, int * ADC,
+		int * ENC, int * DIO) {
+	advance();
+
+	for (int i = 0; i < BOARD_DIO_BANKS; ++i)
+		if (DIOMask & (1 << i))
+			DIO[i] = current.DIO[i];
+
+	for (int i = 0; i < BOARD_ENC_CHANNELS; ++i)
+		if (ENCMask & (1 << i))
+			ENC[i] = current.ENC[i];
+
+	for (int i = 0; i < BOARD_ADC_CHANNELS; ++i)
+		if (ADCMask & (1 << i))
+			ADC[i] = current.ADC[i];
+
+	return 0;
+}
+
+bool Replay_backend::hasBacklog(void) {
+	if (mode != REPLAY_MODE_AFAP || !opened || finished || restart)
+		return false;
+
+	//following frame is decoded ahead and served by the next read
+	return next();
+}
+
+std::string Replay_backend::getName(void) {
+	return "replay";
+}
+
+void Replay_backend::setMode(int Mode, double Speed) {
+	if (Mode == REPLAY_MODE_REALTIME)
+		Speed = 1.0;
+	if (Speed <= 0.0)
+		return;
+
+	speed = Speed;
+	mode = Mode;
+
+	//timing continues from the current frame
+	__sync_fetch_and_or(&restart, REPLAY_RESTART_TIME);
+}
+
+void Replay_backend::rewind(void) {
+	__sync_fetch_and_or(&restart, REPLAY_RESTART_REWIND);
+}
+
+bool Replay_backend::isFinished(void) {
+	return finished;
+}
+
+unsigned int Replay_backend::getReplayed(void) {
+	return replayed;
+}
+
+int Replay_backend::saveCapture(std::string File) {
+	unsigned int Count = captured;
+	FILE * Output = fopen(File.c_str(), "w");
+
+	if (Output == NULL)
+		return -1;
+
+	//entries below captured are not modified any more
+	__sync_synchronize();
+
+	fprintf(Output, "seq,type,channel,mask,value\n");
+	for (unsigned int i = 0; i < Count; ++i)
+		fprintf(Output, "%u,%d,%d,%d,%d\n", captures[i].seq, captures[i].type,
+				captures[i].channel, captures[i].mask, captures[i].value);
+
+	fclose(Output);
+
+	return (int) Count;
+}
+
+unsigned int Replay_backend::getCaptureOverflow(void) {
+	return overflow;
+}
+
+void Replay_backend::advance(void) {
+	int Restart = __sync_lock_test_and_set(&restart, 0);
+
+	if (Restart & REPLAY_RESTART_REWIND) {
+		offset = 0;
+		ahead = false;
+		memset(&current, 0, sizeof(current));
+		replayed = 0;
+		captured = 0;
+		overflow = 0;
+		finished = false;
+	}
+
+	if (Restart)
+		startTime = 0;
+
+	if (finished)
+		return;
+
+	//one recorded frame per read, the interface thread keeps
+	//reading while there is a backlog
+	if (mode == REPLAY_MODE_AFAP) {
+		if (next()) {
+			current = following;
+			ahead = false;
+			++replayed;
+		} else
+			finished = true;
+
+		return;
+	}
+
+	long long Now = RTT::os::TimeService::Instance()->getNSecs();
+
+	//the first frame is served right away, the following ones
+	//when their recorded time comes
+	if (startTime == 0) {
+		if (replayed == 0) {
+			if (!next()) {
+				finished = true;
+				return;
+			}
+
+			current = following;
+			ahead = false;
+			++replayed;
+		}
+
+		startTime = Now;
+		startRecorded = current.timestamp;
+
+		return;
+	}
+
+	long long Target = startRecorded
+			+ (long long) ((Now - startTime) * (double) speed);
+
+	while (next() && following.timestamp <= Target) {
+		current = following;
+		ahead = false;
+		++replayed;
+	}
+
+	if (!ahead)
+		finished = true;
+}
+
+bool Replay_backend::next(void) {
+	int Size;
+
+	if (ahead)
+		return true;
+
+	if (offset >= data.size())
+		return false;
+
+	//frames are encoded against the previous one
+	following = current;
+
+	Size = decodeFrame(following, &data[offset], (int) (data.size() - offset));
+	if (Size < 0) {
+		//truncated recording ends the replay
+		offset = data.size();
+		return false;
+	}
+
+	offset += Size;
+	ahead = true;
+
+	return true;
+}
+
+void Replay_backend::capture(int Type, int Channel, int Mask, int Value) {
+	unsigned int Count = captured;
+
+	if (Count >= captures.size()) {
+		++overflow;
+		return;
+	}
+
+	captures[Count].seq = current.seq;
+	captures[Count].type = Type;
+	captures[Count].channel = Channel;
+	captures[Count].mask = Mask;
+	captures[Count].value = Value;
+
+	//entry is complete before it is counted
+	__sync_synchronize();
+	captured = Count + 1;
+}
@@ -0,0 +1,235 @@
+/**
+ * \file Replay-backend.hpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef REPLAY_BACKEND_HPP
+#define REPLAY_BACKEND_HPP
+
+#include <string>
+#include <vector>
+
+#include "Board-backend.hpp"
+#include "Frame-codec.hpp"
+
+#define REPLAY_MODE_REALTIME 0
+#define REPLAY_MODE_SCALED 1
+#define REPLAY_MODE_AFAP 2
+
+/**
+ * Number of captured writes kept in memory
+ */
+#define REPLAY_CAPTURE_SIZE 262144
+
+#define REPLAY_CAPTURE_DAC 0
+#define REPLAY_CAPTURE_DIO 1
+
+/**
+ * \brief Replay_backend
+ *
+ * Board replaying a recording of Frame_recorder.
+ *
+ * Reads return values of the replayed frame. The frame
+ * advances on every \link readFrame readFrame \endlink,
+ * either following the recorded timestamps in real time
+ * or at a scaled speed, or by one recorded frame per call
+ * with \link hasBacklog hasBacklog \endlink letting the interface
+ * thread read them back to back. After the last frame
+ * its values are kept.
+ *
+ * DAC and DIO writes are captured in memory together with
+ * the sequence number of the replayed frame and can be
+ * saved with \link saveCapture saveCapture \endlink.
+ *
+ * Mode changes, rewind and saving of the capture may be called
+ * from any thread, they are applied or read without locking
+ * the thread reading the board.
+ */
+class Replay_backend: public Board_backend {
+public:
+
+	Replay_backend();
+
+	/**
+	 * \brief open
+	 *
+	 * Loads the recording.
+	 *
+	 * \param[in]	Device		Path of the recording
+	 *
+	 * \return		0 or -5 when the recording could not be loaded
+	 */
+	int open(std::string Device, int Bus, int Slot);
+
+	int close(void);
+
+	bool isOpen(void);
+
+	int readDIO(int bank, int * value);
+
+	int writeDIO(int bank, int mask, int value);
+
+	int readADC(int channel, int * value);
+
+	void setrangeADC(int mask, int value);
+
+	int writeDAC(int channel, int value);
+
+	int configureENC(int channel);
+
+	int readENC(int channel, int * value);
+
+	int readFrame(int ADCMask, int ENCMask, int DIOMask, int * ADC, int * ENC,
+			int * DIO);
+
+	/**
+	 * Recorded frames are not paced in REPLAY_MODE_AFAP
+	 */
+	bool hasBacklog(void);
+
+	std::string getName(void);
+
+	/**
+	 * \brief setMode
+	 *
+	 * \param[in]	Mode		REPLAY_MODE_REALTIME, REPLAY_MODE_SCALED
+	 * 										or REPLAY_MODE_AFAP
+	 * \param[in]	Speed		Multiple of the recorded speed,
+	 * 										used by REPLAY_MODE_SCALED
+	 */
+	void setMode(int Mode, double Speed);
+
+	/**
+	 * \brief rewind
+	 *
+	 * Starts the replay from the first frame with the next read
+	 * and clears the captured writes.
+	 */
+	void rewind(void);
+
+	/**
+	 * \return		true when the last frame was reached
+	 */
+	bool isFinished(void);
+
+	/**
+	 * \return		Number of replayed frames
+	 */
+	unsigned int getReplayed(void);
+
+	/**
+	 * \brief saveCapture
+	 *
+	 * Writes all the writes captured since open or rewind as CSV
+	 * with columns seq, type (0 - DAC, 1 - DIO), channel, mask, value.
+	 *
+	 * \return		Number of saved writes or -1 when the file
+	 * 						could not be created
+	 */
+	int saveCapture(std::string File);
+
+	/**
+	 * \return		Number of writes which did not fit into the capture
+	 */
+	unsigned int getCaptureOverflow(void);
+
+private:
+
+	/**
+	 * Moves to the frame due at this moment
+	 */
+	void advance(void);
+
+	/**
+	 * Decodes the next frame
+	 */
+	bool next(void);
+
+	void capture(int Type, int Channel, int Mask, int Value);
+
+	/**
+	 * Encoded frames of the recording
+	 */
+	std::vector<unsigned char> data;
+
+	size_t offset;
+
+	bool opened;
+
+	volatile bool finished;
+
+	/**
+	 * Set by rewind and setMode, handled by the next read
+	 */
+	volatile int restart;
+
+	/**
+	 * Frame served by the reads
+	 */
+	S626_frame current;
+
+	/**
+	 * Frame following the current one, valid when ahead is true
+	 */
+	S626_frame following;
+
+	bool ahead;
+
+	volatile unsigned int replayed;
+
+	volatile int mode;
+
+	volatile double speed;
+
+	/**
+	 * Start of the replay in the replay clock and in the
+	 * recording, 0 when not started
+	 */
+	long long startTime;
+
+	long long startRecorded;
+
+	struct Capture {
+		unsigned int seq;
+		int type;
+		int channel;
+		int mask;
+		int value;
+	};
+
+	std::vector<Capture> captures;
+
+	/**
+	 * Number of complete entries of captures
+	 */
+	volatile unsigned int captured;
+
+	volatile unsigned int overflow;
+
+	int adcRange;
+};
+
+#endif
@@ -20,6 +20,9 @@
 
 #include "S626API.h"
 
+#include <errno.h>
+#include <sys/mman.h>
+
 ts626 * s626_init(const char * nBoardName, const char * nDeviceName) {
   ts626 * s626;
 
@@ -43,6 +46,14 @@ ts626 * s626_init(const char * nBoardName, const char * nDeviceName) {
   //set all to +/- 5 V range
   s626->adc_range = 0x0000;
 
+  memset(&s626->desc, 0, sizeof(ts626_desc));
+  memset(&s626->frame, 0, sizeof(ts626_frame));
+  memset(&s626->scan, 0, sizeof(ts626_scan));
+  memset(&s626->output, 0, sizeof(ts626_output));
+  s626->output.list.insns = &s626->output.insns[0];
+  s626->frame.list.insns = &s626->frame.insns[0];
+  s626->frame.subset_list.insns = &s626->frame.subset[0];
+
   return s626;
 }
 
@@ -109,6 +120,102 @@ int s626_set_slot( ts626 * s626, unsigned long slot)
 	return 0;
 }
 
+/**
+ * Reads descriptors of all the subdevices and finds
+ * the subdevice of each function by its type.
+ */
+static int s626_describe(ts626 * s626)
+{
+  ts626_desc * desc = &s626->desc;
+  ts626_subd * subd;
+  a4l_sbinfo_t * sbinfo;
+  a4l_chinfo_t * chinfo;
+  a4l_rnginfo_t * rnginfo;
+  unsigned int i, j;
+  int err;
+
+  memset(desc, 0, sizeof(ts626_desc));
+  desc->adc_subd = -1;
+  desc->dac_subd = -1;
+  desc->enc_subd = -1;
+  desc->dio_subd = -1;
+
+  desc->nb_subd = s626->dsc.nb_subd;
+  if (desc->nb_subd > S626_MAX_SUBDEVICES)
+    desc->nb_subd = S626_MAX_SUBDEVICES;
+
+  for (i = 0; i < desc->nb_subd; ++i) {
+    subd = &desc->subd[i];
+
+    err = a4l_get_subdinfo(&s626->dsc, i, &sbinfo);
+    if (err < 0)
+      return err;
+
+    subd->type = sbinfo->flags & A4L_SUBD_TYPES;
+    subd->nb_chan = sbinfo->nb_chan;
+
+    if (subd->type & (A4L_SUBD_DIO | A4L_SUBD_DI | A4L_SUBD_DO)) {
+      err = a4l_sizeof_subd(sbinfo);
+      if (err < 0)
+        return err;
+
+      subd->sample_size = err;
+      subd->nb_bits = subd->nb_chan;
+    } else if (subd->nb_chan > 0) {
+      //channels of the board share their description
+      err = a4l_get_chinfo(&s626->dsc, i, 0, &chinfo);
+      if (err < 0)
+        return err;
+
+      err = a4l_sizeof_chan(chinfo);
+      if (err < 0)
+        return err;
+
+      subd->sample_size = err;
+      subd->nb_bits = chinfo->nb_bits;
+      subd->nb_rng = chinfo->nb_rng;
+      if (subd->nb_rng > S626_MAX_RANGES)
+        subd->nb_rng = S626_MAX_RANGES;
+
+      for (j = 0; j < subd->nb_rng; ++j) {
+        err = a4l_get_rnginfo(&s626->dsc, i, 0, j, &rnginfo);
+        if (err < 0)
+          return err;
+
+        subd->rng_min[j] = rnginfo->min;
+        subd->rng_max[j] = rnginfo->max;
+      }
+    }
+
+    switch (subd->type) {
+    case A4L_SUBD_AI:
+      if (desc->adc_subd < 0)
+        desc->adc_subd = i;
+      break;
+    case A4L_SUBD_AO:
+      if (desc->dac_subd < 0)
+        desc->dac_subd = i;
+      break;
+    case A4L_SUBD_COUNTER:
+      if (desc->enc_subd < 0)
+        desc->enc_subd = i;
+      break;
+    case A4L_SUBD_DIO:
+      if (desc->dio_subd < 0) {
+        desc->dio_subd = i;
+        desc->dio_banks = 1;
+      } else if (desc->dio_subd + desc->dio_banks == i)
+        ++desc->dio_banks;
+      break;
+    }
+  }
+
+  if (desc->dio_banks > 3)
+    desc->dio_banks = 3;
+
+  return 0;
+}
+
 int s626_open(ts626 * s626) {
   int err;
 
@@ -152,10 +259,25 @@ int s626_open(ts626 * s626) {
   if (err < 0) {
     printf("a4l_fill_desc failed (err=%d)\n",
       err);
+    goto out_a4l_fill_desc;
+  }
+
+  //driver metadata is not queried again while the board is open
+  err = s626_describe(s626);
+  if (err < 0) {
+    printf("subdevices of %s could not be described (err=%d)\n",
+      s626->DeviceName, err);
+    goto out_a4l_fill_desc;
   }
 
   return 0;
 
+  out_a4l_fill_desc:
+
+  free(s626->dsc.sbdata);
+  s626->dsc.sbdata = NULL;
+  rt_dev_close(s626->device);
+
   out_rt_dev_open:
 
   a4l_close(&s626->dsc);
@@ -177,6 +299,8 @@ int s626_close(ts626 * s626) {
 
   int err;
 
+  s626_adc_scan_stop(s626);
+
   // close the device
   err = rt_dev_close(s626->device);
   if (err < 0) {
@@ -220,15 +344,12 @@ int s626_gpct_conf_enc(ts626 * s626, unsigned int subd, unsigned int chan) {
   s626->config.data = &s626->data;
   s626->config.data_size = 4 * sizeof(unsigned int);
 
+  //the caller reports the failure of the channel
   err = a4l_snd_insn(&s626->dsc, &s626->config);
-  if (err < 0) {
-    printf("ERROR: configuration of subdevice (%d)\n", err);
-
+  if (err < 0)
     return err;
-  }
 
   return 0;
-
 }
 
 int s626_gpct_read_enc(ts626 * s626, unsigned int subd, unsigned int chan,
@@ -237,12 +358,11 @@ int s626_gpct_read_enc(ts626 * s626, unsigned int subd, unsigned int chan,
   char buf[4];
   int err;
 
+  //errors are reported by the caller, printing here
+  //would leave the real-time domain
   err = a4l_sync_read(&s626->dsc, subd, CHAN(chan), 0, buf, 4);
-  if (err < 0) {
-    printf("ERROR: reading from device (%d)\n", err);
-
+  if (err < 0)
     return err;
-  }
 
   *value = *(signed int *) (&buf[0]);
   if (*value & 0x00800000)
@@ -255,7 +375,7 @@ int s626_get_subd_count(ts626 * s626)
 {
   if(s626)
   {
-    return s626->dsc.nb_subd;
+    return s626->desc.nb_subd;
   }
   else
   {
@@ -263,24 +383,22 @@ int s626_get_subd_count(ts626 * s626)
   }
 }
 
-a4l_sbinfo_t * s626_get_subd_info(ts626 * s626, unsigned int subd)
+const ts626_subd * s626_get_subd(ts626 * s626, unsigned int subd)
 {
-  a4l_sbinfo_t * sbinfo;
-  int err;
-
-  err = a4l_get_subdinfo(&s626->dsc, subd, &sbinfo);
-  if (err < 0) {
-    printf(
-      "a4l_get_subdinfo failed (err = %d)\n",
-      err);
-  }
+  if (s626 == NULL || subd >= s626->desc.nb_subd)
+    return NULL;
 
-  return sbinfo;
+  return &s626->desc.subd[subd];
 }
 
 int s626_get_subd_type(ts626 * s626, unsigned int subd)
 {
-  return s626_get_subd_info(s626, subd)->flags & A4L_SUBD_TYPES;
+  const ts626_subd * desc = s626_get_subd(s626, subd);
+
+  if (desc == NULL)
+    return -EINVAL;
+
+  return desc->type;
 }
 
 int s626_dio_read(ts626 * s626, unsigned int subd, unsigned int mask, int * value)
@@ -292,97 +410,59 @@ int s626_dio_read(ts626 * s626, unsigned int subd, unsigned int mask, int * valu
 
   err = a4l_sync_dio(&s626->dsc, subd, &mask, value);
 
-  if (err < 0) {
-    fprintf(stderr,
-      "a4l_sync_dio() failed (err=%d)\n", err);
-
+  if (err < 0)
     return err;
-  }
 
   return 0;
 }
 
 int s626_dio_write(ts626 * s626, unsigned int subd, unsigned int mask, unsigned int value)
 {
-  int err;
-
-  err = a4l_sync_dio(&s626->dsc, subd, &mask, &value);
-
-  if (err < 0) {
-    printf("a4l_sync_dio() failed (err=%d)\n", err);
-  }
-
-  return err;
+  return a4l_sync_dio(&s626->dsc, subd, &mask, &value);
 }
 
 
-a4l_chinfo_t * s626_adc_get_chan_info(ts626 * s626, unsigned int subd, unsigned int channel)
-{
-  int err = 0;
-  a4l_chinfo_t *chinfo;
-
-  err = a4l_get_chinfo(&s626->dsc, subd, channel, &chinfo);
-  if (err < 0) {
-    printf(
-      "info for channel %d on subdevice %d not available (err=%d)\n",
-      channel, subd, err);
-
-    return NULL;
-  }
-
-  return chinfo;
-}
-
-a4l_rnginfo_t * s626_adc_get_rng_info(ts626 * s626, unsigned int subd, unsigned int channel, int range)
+static unsigned int s626_adc_chan_desc(ts626 * s626, unsigned int subd, unsigned int channel)
 {
-  int err;
-  a4l_rnginfo_t *rnginfo;
+  const ts626_subd * desc = s626_get_subd(s626, subd);
 
-  err = a4l_get_rnginfo(&s626->dsc,
-            subd, channel, range, &rnginfo);
-  if (err < 0) {
-    printf(
-      "failed to recover range descriptor\n");
-
-    return NULL;
-  }
+  //+/- 10 V is the second range when the board has one
+  if (desc != NULL && desc->nb_rng < 2)
+    return channel & 0xFFFF;
 
-  //min value inside rnginfo->min
-  //max value inside rnginfo->max
-
-  return rnginfo;
-}
+  if( s626->adc_range & (1<<channel))
+    return (channel & 0xFFFF) | 0x010000;
 
-int s626_adc_get_scan_size(ts626 * s626, unsigned int subd, unsigned int channel)
-{
-  return a4l_sizeof_chan(s626_adc_get_chan_info(s626, subd, channel));
+  return channel & 0xFFFF;
 }
 
 int s626_adc_read(ts626 * s626, unsigned int subd, unsigned int channel, char * buffer, unsigned int count)
 {
-  int err;
-
-  static int range;
-
-  range = 0x00;
-
-  if( s626->adc_range & (1<<channel))
-  	range = 0x010000;
+  const ts626_subd * desc = s626_get_subd(s626, subd);
 
-  //we are reading 16 bits which is 2 bytes
-  //count is the number of measurements we want to
-  //read
-  //so total number of bytes is 2 * count
-  err = a4l_sync_read(&s626->dsc,
-              subd, (channel & 0xFFFF) | range, 0, buffer, count*2);
+  if (desc == NULL)
+    return -ENODEV;
 
-  return err;
+  //count is the number of measurements we want to read,
+  //each of the sample size of the subdevice
+  return a4l_sync_read(&s626->dsc, subd, s626_adc_chan_desc(s626, subd, channel),
+              0, buffer, count * desc->sample_size);
 }
 
 int s626_adc_set_range(ts626 * s626, unsigned int mask, unsigned int ranges)
 {
+	unsigned int i;
+
 	s626->adc_range = (s626->adc_range & ~mask) | (ranges & mask);
 
+	//update ranges in the prebuilt frame
+	for (i = 0; i < s626->frame.list.count; ++i) {
+		a4l_insn_t * insn = &s626->frame.insns[i];
+
+		if (insn->type == A4L_INSN_READ && insn->idx_subd == s626->frame.adc_subd)
+			insn->chan_desc = s626_adc_chan_desc(s626, insn->idx_subd, insn->chan_desc & 0xFFFF);
+	}
+
 	return ranges;
 }
 
@@ -401,34 +481,375 @@ int s626_dac_write(ts626 * s626, unsigned int subd, unsigned int channel, char *
   return err;
 }
 
+int s626_frame_configure(ts626 * s626, unsigned int adc_subd, unsigned int enc_subd,
+    unsigned int dio_subd, unsigned int adc_mask, unsigned int enc_mask,
+    unsigned int dio_mask)
+{
+  ts626_frame * frame = &s626->frame;
+  const ts626_subd * subd;
+  a4l_insn_t * insn;
+  unsigned int i;
+
+  frame->list.count = 0;
+  frame->adc_subd = adc_subd;
+  frame->enc_subd = enc_subd;
+  frame->dio_subd = dio_subd;
+  frame->adc_mask = adc_mask & 0xFFFF;
+  frame->enc_mask = enc_mask & 0x3F;
+  frame->dio_mask = dio_mask & 0x07;
+
+  //only channels which the subdevices have
+  subd = s626_get_subd(s626, adc_subd);
+  if (subd == NULL || subd->type != A4L_SUBD_AI)
+    frame->adc_mask = 0;
+  else if (subd->nb_chan < 16)
+    frame->adc_mask &= (1 << subd->nb_chan) - 1;
+
+  subd = s626_get_subd(s626, enc_subd);
+  if (subd == NULL || subd->type != A4L_SUBD_COUNTER)
+    frame->enc_mask = 0;
+  else if (subd->nb_chan < 6)
+    frame->enc_mask &= (1 << subd->nb_chan) - 1;
+
+  if ((int) dio_subd < 0)
+    frame->dio_mask = 0;
+
+  for (i = 0; i < 3; ++i) {
+    frame->dio_insn[i] = -1;
+
+    if (!(frame->dio_mask & (1 << i)))
+      continue;
+
+    //DIO data is a pair of mask and bits of the subdevice sample size
+    subd = s626_get_subd(s626, dio_subd + i);
+    if (subd == NULL || subd->type != A4L_SUBD_DIO) {
+      frame->dio_mask &= ~(1 << i);
+      continue;
+    }
+
+    frame->dio_size[i] = subd->sample_size;
+    if (frame->dio_size[i] > sizeof(unsigned int))
+      return -EINVAL;
+
+    frame->dio_insn[i] = frame->list.count;
+    insn = &frame->insns[frame->list.count++];
+    insn->type = A4L_INSN_BITS;
+    insn->idx_subd = dio_subd + i;
+    insn->chan_desc = 0;
+    insn->data_size = 2 * frame->dio_size[i];
+    insn->data = &frame->dio_data[i][0];
+  }
 
+  for (i = 0; i < 6; ++i) {
+    frame->enc_insn[i] = -1;
 
+    if (!(frame->enc_mask & (1 << i)))
+      continue;
 
+    frame->enc_insn[i] = frame->list.count;
+    insn = &frame->insns[frame->list.count++];
+    insn->type = A4L_INSN_READ;
+    insn->idx_subd = enc_subd;
+    insn->chan_desc = CHAN(i);
+    insn->data_size = sizeof(int);
+    insn->data = &frame->enc_data[i];
+  }
 
+  for (i = 0; i < 16; ++i) {
+    frame->adc_insn[i] = -1;
 
+    if (!(frame->adc_mask & (1 << i)))
+      continue;
 
+    frame->adc_insn[i] = frame->list.count;
+    insn = &frame->insns[frame->list.count++];
+    insn->type = A4L_INSN_READ;
+    insn->idx_subd = adc_subd;
+    insn->chan_desc = s626_adc_chan_desc(s626, adc_subd, i);
+    insn->data_size = sizeof(unsigned short);
+    insn->data = &frame->adc_data[i];
+  }
 
+  return 0;
+}
 
+int s626_frame_read(ts626 * s626, unsigned int adc_mask, unsigned int enc_mask,
+    unsigned int dio_mask, int * adc, int * enc, int * dio)
+{
+  ts626_frame * frame = &s626->frame;
+  a4l_insnlst_t * list;
+  unsigned int i;
+  int err;
 
+  adc_mask &= frame->adc_mask;
+  enc_mask &= frame->enc_mask;
+  dio_mask &= frame->dio_mask;
+
+  if (adc_mask == frame->adc_mask && enc_mask == frame->enc_mask
+      && dio_mask == frame->dio_mask) {
+    list = &frame->list;
+  } else {
+    //gather selected instructions, order of the full list is kept
+    list = &frame->subset_list;
+    list->count = 0;
+
+    for (i = 0; i < 3; ++i)
+      if (dio_mask & (1 << i))
+        frame->subset[list->count++] = frame->insns[frame->dio_insn[i]];
+
+    for (i = 0; i < 6; ++i)
+      if (enc_mask & (1 << i))
+        frame->subset[list->count++] = frame->insns[frame->enc_insn[i]];
+
+    for (i = 0; i < 16; ++i)
+      if (adc_mask & (1 << i))
+        frame->subset[list->count++] = frame->insns[frame->adc_insn[i]];
+  }
 
+  if (list->count == 0)
+    return 0;
 
+  for (i = 0; i < 3; ++i) {
+    //nothing is written, only read
+    frame->dio_data[i][0] = 0;
+    frame->dio_data[i][1] = 0;
+  }
 
+  err = a4l_snd_insnlist(&s626->dsc, list);
+  if (err < 0)
+    return err;
 
+  for (i = 0; i < 3; ++i) {
+    if (!(dio_mask & (1 << i)))
+      continue;
+
+    //bits follow the mask, both of the subdevice sample size
+    switch (frame->dio_size[i]) {
+    case sizeof(unsigned char):
+      dio[i] = ((unsigned char *) &frame->dio_data[i][0])[1];
+      break;
+    case sizeof(unsigned short):
+      dio[i] = ((unsigned short *) &frame->dio_data[i][0])[1];
+      break;
+    default:
+      dio[i] = frame->dio_data[i][1];
+      break;
+    }
+  }
 
+  for (i = 0; i < 6; ++i) {
+    if (!(enc_mask & (1 << i)))
+      continue;
 
+    enc[i] = frame->enc_data[i];
+    if (enc[i] & 0x00800000)
+      enc[i] = enc[i] | 0xff000000;
+  }
 
+  for (i = 0; i < 16; ++i) {
+    if (adc_mask & (1 << i))
+      adc[i] = frame->adc_data[i] & 0x3FFF;
+  }
 
+  return 0;
+}
 
+int s626_write_outputs(ts626 * s626, unsigned int dac_subd, unsigned int dio_subd,
+    unsigned int dac_mask, const int * dac, unsigned int dio_mask,
+    const int * dio_masks, const int * dio_values)
+{
+  ts626_output * output = &s626->output;
+  const ts626_subd * subd;
+  a4l_insn_t * insn;
+  unsigned int i;
+  int size;
+
+  output->list.count = 0;
+
+  for (i = 0; i < 4; ++i) {
+    if (!(dac_mask & (1 << i)))
+      continue;
+
+    output->dac_data[i] = (unsigned short) (dac[i] & 0xFFFF);
+
+    insn = &output->insns[output->list.count++];
+    insn->type = A4L_INSN_WRITE;
+    insn->idx_subd = dac_subd;
+    insn->chan_desc = CHAN(i);
+    insn->data_size = sizeof(unsigned short);
+    insn->data = &output->dac_data[i];
+  }
 
+  for (i = 0; i < 3; ++i) {
+    if (!(dio_mask & (1 << i)))
+      continue;
+
+    //DIO data is a pair of mask and bits of the subdevice sample size
+    subd = s626_get_subd(s626, dio_subd + i);
+    if (subd == NULL)
+      return -ENODEV;
+
+    size = subd->sample_size;
+    switch (size) {
+    case sizeof(unsigned char):
+      ((unsigned char *) &output->dio_data[i][0])[0] = dio_masks[i];
+      ((unsigned char *) &output->dio_data[i][0])[1] = dio_values[i];
+      break;
+    case sizeof(unsigned short):
+      ((unsigned short *) &output->dio_data[i][0])[0] = dio_masks[i];
+      ((unsigned short *) &output->dio_data[i][0])[1] = dio_values[i];
+      break;
+    case sizeof(unsigned int):
+      output->dio_data[i][0] = dio_masks[i];
+      output->dio_data[i][1] = dio_values[i];
+      break;
+    default:
+      return -EINVAL;
+    }
+
+    insn = &output->insns[output->list.count++];
+    insn->type = A4L_INSN_BITS;
+    insn->idx_subd = dio_subd + i;
+    insn->chan_desc = 0;
+    insn->data_size = 2 * size;
+    insn->data = &output->dio_data[i][0];
+  }
 
+  if (output->list.count == 0)
+    return 0;
 
+  return a4l_snd_insnlist(&s626->dsc, &output->list);
+}
 
+int s626_adc_scan_start(ts626 * s626, unsigned int subd, unsigned int mask,
+    unsigned int period_ns)
+{
+  ts626_scan * scan = &s626->scan;
+  const ts626_subd * desc;
+  unsigned int i;
+  int err;
 
+  s626_adc_scan_stop(s626);
 
+  desc = s626_get_subd(s626, subd);
+  if (desc == NULL || desc->sample_size == 0)
+    return -ENODEV;
 
+  scan->subd = subd;
+  scan->sample_size = desc->sample_size;
+  scan->nb_chan = 0;
 
+  //poll list in ascending channel order
+  for (i = 0; i < 16; ++i) {
+    if (mask & (1 << i)) {
+      scan->channels[scan->nb_chan] = i;
+      scan->chan_descs[scan->nb_chan] = s626_adc_chan_desc(s626, subd, i);
+      ++scan->nb_chan;
+    }
+  }
 
+  if (scan->nb_chan == 0)
+    return 0;
+
+  memset(&scan->cmd, 0, sizeof(a4l_cmd_t));
+  scan->cmd.idx_subd = subd;
+  scan->cmd.start_src = TRIG_NOW;
+  scan->cmd.start_arg = 0;
+  scan->cmd.scan_begin_src = TRIG_TIMER;
+  scan->cmd.scan_begin_arg = period_ns;
+  scan->cmd.convert_src = TRIG_NOW;
+  scan->cmd.convert_arg = 0;
+  scan->cmd.scan_end_src = TRIG_COUNT;
+  scan->cmd.scan_end_arg = scan->nb_chan;
+  scan->cmd.stop_src = TRIG_NONE;
+  scan->cmd.stop_arg = 0;
+  scan->cmd.nb_chan = scan->nb_chan;
+  scan->cmd.chan_descs = &scan->chan_descs[0];
+
+  err = a4l_snd_command(&s626->dsc, &scan->cmd);
+  if (err < 0)
+    return err;
+
+  err = a4l_get_bufsize(&s626->dsc, subd, &scan->bufsize);
+  if (err < 0)
+    goto out_cancel;
+
+  err = a4l_mmap(&s626->dsc, subd, scan->bufsize, &scan->map);
+  if (err < 0)
+    goto out_cancel;
+
+  scan->front = 0;
+  scan->pending = 0;
+  scan->running = 1;
+
+  return 0;
+
+  out_cancel:
+
+  a4l_snd_cancel(&s626->dsc, subd);
+
+  return err;
+}
+
+int s626_adc_scan_read(ts626 * s626, int * adc)
+{
+  ts626_scan * scan = &s626->scan;
+  unsigned long avail = 0;
+  unsigned long scan_size;
+  unsigned long offset;
+  unsigned int nb_scans;
+  unsigned int i;
+  int err;
+
+  if (!scan->running)
+    return 0;
+
+  //release what was consumed last time and get newly available data
+  err = a4l_mark_bufrw(&s626->dsc, scan->subd, scan->pending, &avail);
+  scan->pending = 0;
+  if (err < 0)
+    return err;
+
+  scan_size = scan->nb_chan * scan->sample_size;
+  nb_scans = avail / scan_size;
+
+  if (nb_scans == 0)
+    return 0;
+
+  //only the latest complete scan is taken, samples are
+  //read in place from the mapped buffer
+  offset = scan->front + (nb_scans - 1) * scan_size;
+
+  for (i = 0; i < scan->nb_chan; ++i) {
+    char * sample = (char *) scan->map
+        + (offset + i * scan->sample_size) % scan->bufsize;
+
+    if (scan->sample_size == sizeof(unsigned int))
+      adc[scan->channels[i]] = *(unsigned int *) sample & 0x3FFF;
+    else
+      adc[scan->channels[i]] = *(unsigned short *) sample & 0x3FFF;
+  }
+
+  scan->front = (scan->front + nb_scans * scan_size) % scan->bufsize;
+  scan->pending = nb_scans * scan_size;
 
+  return nb_scans;
+}
+
+int s626_adc_scan_stop(ts626 * s626)
+{
+  ts626_scan * scan = &s626->scan;
+  int err;
 
+  if (!scan->running)
+    return 0;
 
+  scan->running = 0;
 
+  err = a4l_snd_cancel(&s626->dsc, scan->subd);
+
+  munmap(scan->map, scan->bufsize);
+  scan->map = NULL;
+
+  return err;
+}
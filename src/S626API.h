@@ -34,6 +34,112 @@ extern "C"
 {
 #endif
 
+//maximum number of subdevices kept in the descriptor table
+#define S626_MAX_SUBDEVICES 16
+
+//ranges kept for each subdevice
+#define S626_MAX_RANGES 4
+
+typedef struct {
+  //A4L_SUBD_* type
+  unsigned int type;
+  unsigned int nb_chan;
+
+  //size of a sample in bytes, for DIO the size of the bits of a bank
+  unsigned int sample_size;
+  unsigned int nb_bits;
+
+  //limits of the ranges of channel 0 in millionths of a unit
+  unsigned int nb_rng;
+  long rng_min[S626_MAX_RANGES];
+  long rng_max[S626_MAX_RANGES];
+} ts626_subd;
+
+typedef struct {
+  ts626_subd subd[S626_MAX_SUBDEVICES];
+  unsigned int nb_subd;
+
+  //subdevice of each function, -1 when the board has none
+  int adc_subd;
+  int dac_subd;
+  int enc_subd;
+
+  //first of the consecutive DIO subdevices, one for each bank
+  int dio_subd;
+  unsigned int dio_banks;
+} ts626_desc;
+
+//maximum number of instructions in a frame
+//3 DIO banks, 6 encoders and 16 ADC channels
+#define S626_FRAME_MAX_INSNS 25
+
+typedef struct {
+  //prebuilt list submitted with a single ioctl
+  a4l_insn_t insns[S626_FRAME_MAX_INSNS];
+  a4l_insnlst_t list;
+
+  unsigned int adc_subd;
+  unsigned int enc_subd;
+  unsigned int dio_subd;
+
+  //channels covered by the list
+  unsigned int adc_mask;
+  unsigned int enc_mask;
+  unsigned int dio_mask;
+
+  //size of a DIO sample for each bank
+  unsigned int dio_size[3];
+
+  //index of the instruction of each channel in insns
+  int adc_insn[16];
+  int enc_insn[6];
+  int dio_insn[3];
+
+  //list of the instructions selected for a single read
+  a4l_insn_t subset[S626_FRAME_MAX_INSNS];
+  a4l_insnlst_t subset_list;
+
+  //buffers filled by the driver
+  unsigned short adc_data[16];
+  int enc_data[6];
+  unsigned int dio_data[3][2];
+} ts626_frame;
+
+//4 DAC channels and 3 DIO banks
+#define S626_OUTPUT_MAX_INSNS 7
+
+typedef struct {
+  a4l_insn_t insns[S626_OUTPUT_MAX_INSNS];
+  a4l_insnlst_t list;
+
+  unsigned short dac_data[4];
+  unsigned int dio_data[3][2];
+} ts626_output;
+
+typedef struct {
+  unsigned int subd;
+
+  //channel number on each position of the scan
+  unsigned int channels[16];
+  unsigned int chan_descs[16];
+  unsigned int nb_chan;
+  //bytes of one sample in the buffer
+  unsigned int sample_size;
+
+  a4l_cmd_t cmd;
+
+  //Analogy ring buffer mapped into user space
+  void * map;
+  unsigned long bufsize;
+
+  //offset of the first not consumed byte
+  unsigned long front;
+  //bytes consumed but not yet released to the driver
+  unsigned long pending;
+
+  int running;
+} ts626_scan;
+
 typedef struct {
   char * DeviceName;
   char * BoardName;
@@ -48,6 +154,15 @@ typedef struct {
   //'0' -> +/- 5  V
   //'1' -> +/- 10 V
   int adc_range;
+
+  //filled once by s626_open, not changed until the board is closed
+  ts626_desc desc;
+
+  ts626_frame frame;
+
+  ts626_scan scan;
+
+  ts626_output output;
 } ts626;
 
 ts626 * s626_init(const char * nBoardName, const char * nDeviceName);
@@ -64,6 +179,10 @@ int s626_open(ts626 * s626);
 
 int s626_close(ts626 * s626);
 
+/**
+ * Configures the channel as quadrature encoder.
+ * Returns 0 or a negative error code, which is not printed.
+ */
 int s626_gpct_conf_enc(ts626 * s626, unsigned int subd, unsigned int chan);
 
 int s626_gpct_read_enc(ts626 * s626, unsigned int subd, unsigned int chan,
@@ -71,7 +190,11 @@ int s626_gpct_read_enc(ts626 * s626, unsigned int subd, unsigned int chan,
 
 int s626_get_subd_count(ts626 * s626);
 
-a4l_sbinfo_t * s626_get_subd_info(ts626 * s626, unsigned int subd);
+/**
+ * Returns the cached descriptor of a subdevice,
+ * NULL when subd is out of the table.
+ */
+const ts626_subd * s626_get_subd(ts626 * s626, unsigned int subd);
 
 int s626_get_subd_type(ts626 * s626, unsigned int subd);
 
@@ -87,6 +210,56 @@ int s626_adc_get_range(ts626 * s626);
 
 int s626_dac_write(ts626 * s626, unsigned int subd, unsigned int channel, char * buffer);
 
+/**
+ * Builds the instruction list which reads all the selected
+ * DIO banks, encoders and ADC channels at once.
+ * DIO banks are read from consecutive subdevices starting at dio_subd.
+ * Channels which the subdevices do not have are left out.
+ * Has to be called again when channels change, ADC ranges
+ * are updated by s626_adc_set_range.
+ */
+int s626_frame_configure(ts626 * s626, unsigned int adc_subd, unsigned int enc_subd,
+    unsigned int dio_subd, unsigned int adc_mask, unsigned int enc_mask,
+    unsigned int dio_mask);
+
+/**
+ * Submits the prebuilt instruction list with a single ioctl.
+ * Masks select which of the configured channels are read,
+ * channels not covered by s626_frame_configure are ignored.
+ * Only the read entries are written to adc, enc and dio,
+ * on error none of them is touched.
+ */
+int s626_frame_read(ts626 * s626, unsigned int adc_mask, unsigned int enc_mask,
+    unsigned int dio_mask, int * adc, int * enc, int * dio);
+
+/**
+ * Writes the selected DAC channels and DIO banks with a single ioctl.
+ * DIO banks are written to consecutive subdevices starting at dio_subd,
+ * each with its own mask of outputs.
+ */
+int s626_write_outputs(ts626 * s626, unsigned int dac_subd, unsigned int dio_subd,
+    unsigned int dac_mask, const int * dac, unsigned int dio_mask,
+    const int * dio_masks, const int * dio_values);
+
+/**
+ * Starts hardware timed acquisition of the ADC channels selected
+ * by mask. The board scans the poll list every period_ns nanoseconds
+ * into the Analogy buffer which is mapped into user space.
+ */
+int s626_adc_scan_start(ts626 * s626, unsigned int subd, unsigned int mask,
+    unsigned int period_ns);
+
+/**
+ * Takes the latest complete scan directly from the mapped buffer
+ * and releases all older ones. Only the scanned channels of adc
+ * are written.
+ * Returns the number of complete scans since the last call,
+ * 0 when there was none, negative error code otherwise.
+ */
+int s626_adc_scan_read(ts626 * s626, int * adc);
+
+int s626_adc_scan_stop(ts626 * s626);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,139 @@
+/**
+ * \file Seqlock.hpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+#include <cstddef>
+
+/**
+ * \brief Seqlock
+ *
+ * Single writer, multiple readers sequence lock.
+ *
+ * The writer never blocks. Readers copy the whole value
+ * and retry only when the copy overlapped a write, so
+ * they always obtain a coherent snapshot.
+ * Sequence counter and the data are kept in separate
+ * cache lines.
+ *
+ * T has to be a POD type.
+ */
+template<class T>
+class Seqlock {
+public:
+
+	Seqlock() :
+			sequence(0) {
+	}
+
+	/**
+	 * \brief write
+	 *
+	 * Publishes new value. Only one thread may write.
+	 */
+	void write(const T & Data) {
+		unsigned int Sequence = sequence;
+
+		sequence = Sequence + 1;
+		__sync_synchronize();
+
+		data = Data;
+
+		__sync_synchronize();
+		sequence = Sequence + 2;
+	}
+
+	/**
+	 * \brief read
+	 *
+	 * Copies the last published value.
+	 *
+	 * \return		Number of writes completed when the copy was taken
+	 */
+	unsigned int read(T & Data) const {
+		unsigned int Begin, End;
+
+		do {
+			Begin = sequence;
+			__sync_synchronize();
+
+			Data = data;
+
+			__sync_synchronize();
+			End = sequence;
+		} while ((Begin & 1) || Begin != End);
+
+		return Begin >> 1;
+	}
+
+	/**
+	 * \brief tryRead
+	 *
+	 * Copies the last published value once, without retrying.
+	 *
+	 * \param[out]	Version		Number of writes completed when the
+	 * 											copy was taken, valid only on success
+	 *
+	 * \return		false when the copy overlapped a write
+	 * 						and Data is not coherent
+	 */
+	bool tryRead(T & Data, unsigned int * Version = NULL) const {
+		unsigned int Begin, End;
+
+		Begin = sequence;
+		__sync_synchronize();
+
+		Data = data;
+
+		__sync_synchronize();
+		End = sequence;
+
+		if (Version)
+			*Version = Begin >> 1;
+
+		return !(Begin & 1) && Begin == End;
+	}
+
+	/**
+	 * \brief version
+	 *
+	 * \return		Number of completed writes
+	 */
+	unsigned int version(void) const {
+		return sequence >> 1;
+	}
+
+private:
+
+	volatile unsigned int sequence __attribute__ ((aligned (64)));
+
+	T data __attribute__ ((aligned (64)));
+
+};
+
+#endif
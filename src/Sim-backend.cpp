@@ -0,0 +1,199 @@
+/**
+ * \file Sim-backend.cpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "Sim-backend.hpp"
+
+#include <rtt/os/TimeService.hpp>
+
+Sim_backend::Sim_backend() :
+		opened(false), latency(0), ticks(0), ENCConfigured(0), adcRange(0) {
+	clearErrors();
+
+	for (int i = 0; i < BOARD_DAC_CHANNELS; ++i)
+		DAC[i] = 0x2000;
+
+	for (int i = 0; i < BOARD_ENC_CHANNELS; ++i)
+		ENC[i] = 0;
+
+	for (int i = 0; i < BOARD_DIO_BANKS * 2; ++i)
+		DIO[i] = 0;
+}
+
+int Sim_backend::call(int Peripheral, int Channel) {
+	int Latency = latency;
+
+	if (Latency > 0) {
+		RTT::os::TimeService * ts = RTT::os::TimeService::Instance();
+		RTT::os::TimeService::nsecs end = ts->getNSecs() + Latency;
+
+		while (ts->getNSecs() < end)
+			;
+	}
+
+	if (errorCount[Peripheral][Channel] > 0) {
+		if (__sync_fetch_and_sub(&errorCount[Peripheral][Channel], 1) > 0)
+			return errorCode[Peripheral][Channel];
+	}
+
+	return 0;
+}
+
+int Sim_backend::open(std::string /* Device */, int /* Bus */, int /* Slot */) {
+	opened = true;
+	return 0;
+}
+
+int Sim_backend::close(void) {
+	opened = false;
+	return 0;
+}
+
+bool Sim_backend::isOpen(void) {
+	return opened;
+}
+
+int Sim_backend::readDIO(int bank, int * value) {
+	int err = call(BOARD_PERIPHERAL_DIO, bank);
+	if (err < 0)
+		return err;
+
+	int mask = DIO[bank * 2];
+	int inputs = (++ticks >> 8) & 0xFFFF;
+
+	*value = ((DIO[bank * 2 + 1] & mask) | (inputs & ~mask)) & 0xFFFF;
+
+	return 0;
+}
+
+int Sim_backend::writeDIO(int bank, int mask, int value) {
+	int err = call(BOARD_PERIPHERAL_DIO, bank);
+	if (err < 0)
+		return err;
+
+	DIO[bank * 2] = mask & 0xFFFF;
+	DIO[bank * 2 + 1] = value & 0xFFFF;
+
+	return 0;
+}
+
+int Sim_backend::readADC(int channel, int * value) {
+	int err = call(BOARD_PERIPHERAL_ADC, channel);
+	if (err < 0)
+		return err;
+
+	if (channel < BOARD_DAC_CHANNELS) {
+		*value = DAC[channel] & 0x3FFF;
+	} else {
+		//triangle wave, each channel with different slope
+		unsigned int phase = (++ticks * (unsigned int) channel) & 0x7FFF;
+
+		if (phase & 0x4000)
+			phase = 0x7FFF - phase;
+
+		*value = phase & 0x3FFF;
+	}
+
+	return 0;
+}
+
+void Sim_backend::setrangeADC(int mask, int value) {
+	adcRange = (adcRange & ~mask) | (value & mask);
+}
+
+int Sim_backend::writeDAC(int channel, int value) {
+	int err = call(BOARD_PERIPHERAL_DAC, channel);
+	if (err < 0)
+		return err;
+
+	DAC[channel] = value & 0x3FFF;
+
+	return 0;
+}
+
+int Sim_backend::configureENC(int channel) {
+	int err = call(BOARD_PERIPHERAL_ENC, channel);
+	if (err < 0)
+		return err;
+
+	ENCConfigured |= 1 << channel;
+	ENC[channel] = 0;
+
+	return 0;
+}
+
+int Sim_backend::readENC(int channel, int * value) {
+	int err = call(BOARD_PERIPHERAL_ENC, channel);
+	if (err < 0)
+		return err;
+
+	if (ENCConfigured & (1 << channel))
+		ENC[channel] += channel + 1;
+
+	*value = ENC[channel];
+
+	return 0;
+}
+
+std::string Sim_backend::getName(void) {
+	return "sim";
+}
+
+void Sim_backend::setLatency(int Latency) {
+	latency = Latency < 0 ? 0 : Latency;
+}
+
+int Sim_backend::getLatency(void) {
+	return latency;
+}
+
+bool Sim_backend::injectError(int Peripheral, int Channel, int Error,
+		int Count) {
+	if (Peripheral < 0 || Peripheral >= BOARD_PERIPHERALS)
+		return false;
+
+	//zero or positive codes would be taken as success by the callers
+	if (Error >= 0)
+		return false;
+
+	for (int i = 0; i < BOARD_ADC_CHANNELS; ++i) {
+		if (Channel < 0 || Channel == i) {
+			errorCode[Peripheral][i] = Error;
+			errorCount[Peripheral][i] = Count;
+		}
+	}
+
+	return true;
+}
+
+void Sim_backend::clearErrors(void) {
+	for (int p = 0; p < BOARD_PERIPHERALS; ++p) {
+		for (int i = 0; i < BOARD_ADC_CHANNELS; ++i) {
+			errorCount[p][i] = 0;
+			errorCode[p][i] = 0;
+		}
+	}
+}
@@ -0,0 +1,133 @@
+/**
+ * \file Sim-backend.hpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef SIM_BACKEND_HPP
+#define SIM_BACKEND_HPP
+
+#include "Board-backend.hpp"
+
+/**
+ * \brief Sim_backend
+ *
+ * In-process simulated Sensoray 626 board.
+ *
+ * Models 16 ADC, 4 DAC, 6 ENC channels and 3 DIO banks.
+ * ADC channels 0-3 read back DAC channels 0-3, the remaining
+ * channels produce triangle waves. Configured encoders count
+ * up by (channel + 1) on every read and DIO inputs follow a
+ * slow counter while outputs read back what was written.
+ *
+ * Every call can be delayed by configurable latency and
+ * errors can be injected per peripheral and channel, which
+ * allows to profile and test Interface_thread without
+ * Xenomai and a physical card.
+ */
+class Sim_backend: public Board_backend {
+public:
+
+	Sim_backend();
+
+	int open(std::string Device, int Bus, int Slot);
+
+	int close(void);
+
+	bool isOpen(void);
+
+	int readDIO(int bank, int * value);
+
+	int writeDIO(int bank, int mask, int value);
+
+	int readADC(int channel, int * value);
+
+	void setrangeADC(int mask, int value);
+
+	int writeDAC(int channel, int value);
+
+	int configureENC(int channel);
+
+	int readENC(int channel, int * value);
+
+	std::string getName(void);
+
+	/**
+	 * \brief setLatency
+	 *
+	 * Sets time every call spends busy waiting,
+	 * emulating the cost of the driver ioctl.
+	 *
+	 * \param[in]	Latency		Latency in nanoseconds
+	 */
+	void setLatency(int Latency);
+
+	int getLatency(void);
+
+	/**
+	 * \brief injectError
+	 *
+	 * Makes next calls fail.
+	 *
+	 * \param[in]	Peripheral	BOARD_PERIPHERAL_ADC, BOARD_PERIPHERAL_DAC,
+	 * 											BOARD_PERIPHERAL_ENC or BOARD_PERIPHERAL_DIO
+	 * \param[in]	Channel			Channel or bank, -1 for all of them
+	 * \param[in]	Error				Negative error code to be returned
+	 * \param[in]	Count				Number of calls which fail
+	 * \return		false if the peripheral or the error code is invalid
+	 */
+	bool injectError(int Peripheral, int Channel, int Error, int Count);
+
+	void clearErrors(void);
+
+private:
+
+	/**
+	 * Spends the latency and returns injected error
+	 * for the peripheral channel or 0
+	 */
+	int call(int Peripheral, int Channel);
+
+	bool opened;
+
+	volatile int latency;
+
+	volatile int errorCode[BOARD_PERIPHERALS][BOARD_ADC_CHANNELS];
+
+	volatile int errorCount[BOARD_PERIPHERALS][BOARD_ADC_CHANNELS];
+
+	unsigned int ticks;
+
+	int DAC[BOARD_DAC_CHANNELS];
+
+	int ENC[BOARD_ENC_CHANNELS];
+
+	int ENCConfigured;
+
+	int DIO[BOARD_DIO_BANKS * 2];
+
+	int adcRange;
+
+};
+#endif
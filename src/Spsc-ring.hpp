@@ -0,0 +1,125 @@
+/**
+ * \file Spsc-ring.hpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef SPSC_RING_HPP
+#define SPSC_RING_HPP
+
+/**
+ * \brief Spsc_ring
+ *
+ * Single producer, single consumer ring buffer.
+ *
+ * Neither side blocks or allocates, the producer fails
+ * when the ring is full. Indexes of both sides are kept
+ * in separate cache lines.
+ *
+ * T has to be a POD type and N a power of two.
+ */
+template<class T, unsigned int N>
+class Spsc_ring {
+public:
+
+	Spsc_ring() :
+			head(0), tail(0) {
+		//N has to be a power of two, indexes wrap around
+		typedef char PowerOfTwo[(N & (N - 1)) == 0 ? 1 : -1];
+		(void) sizeof(PowerOfTwo);
+	}
+
+	/**
+	 * \brief push
+	 *
+	 * Copies the item into the ring. Called only by the producer.
+	 *
+	 * \return		false when the ring is full
+	 */
+	bool push(const T & Item) {
+		unsigned int Head = head;
+
+		if (Head - tail == N)
+			return false;
+
+		items[Head & (N - 1)] = Item;
+
+		//item is visible before the index
+		__sync_synchronize();
+		head = Head + 1;
+
+		return true;
+	}
+
+	/**
+	 * \brief front
+	 *
+	 * Called only by the consumer.
+	 *
+	 * \return		Oldest item, valid until \link pop pop \endlink,
+	 * 						or NULL when the ring is empty
+	 */
+	const T * front(void) {
+		unsigned int Tail = tail;
+
+		if (head == Tail)
+			return NULL;
+
+		__sync_synchronize();
+
+		return &items[Tail & (N - 1)];
+	}
+
+	/**
+	 * \brief pop
+	 *
+	 * Releases the item returned by \link front front \endlink.
+	 */
+	void pop(void) {
+		//item is read before its slot is released
+		__sync_synchronize();
+		tail = tail + 1;
+	}
+
+	/**
+	 * \brief size
+	 *
+	 * \return		Number of items in the ring
+	 */
+	unsigned int size(void) const {
+		return head - tail;
+	}
+
+private:
+
+	volatile unsigned int head __attribute__ ((aligned (64)));
+
+	volatile unsigned int tail __attribute__ ((aligned (64)));
+
+	T items[N] __attribute__ ((aligned (64)));
+
+};
+
+#endif
@@ -0,0 +1,195 @@
+/**
+ * \file Waveform-player.cpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "Waveform-player.hpp"
+
+Waveform_player::Waveform_player() {
+	for (int i = 0; i < BOARD_DAC_CHANNELS; ++i) {
+		channels[i].segments[0].count = 0;
+		channels[i].segments[1].count = 0;
+		channels[i].slots = 0;
+		channels[i].stopRequest = 0;
+		channels[i].completed = 0;
+		channels[i].position = 0;
+		channels[i].wait = 0;
+	}
+}
+
+int Waveform_player::load(int Channel, const std::vector<int> & Samples,
+		int Mode, int Divider) {
+	int Slots, Free;
+
+	if (Channel < 0 || Channel >= BOARD_DAC_CHANNELS || Samples.empty()
+			|| Samples.size() > WAVEFORM_MAX_SAMPLES || Divider < 1
+			|| (Mode != WAVEFORM_MODE_ONESHOT && Mode != WAVEFORM_MODE_LOOP))
+		return -1;
+
+	Waveform_player::Channel & Ch = channels[Channel];
+
+	mutexLoad.lock();
+
+	//withdraw the queued segment, from now on the played one
+	//can only finish and the other one is not read
+	do {
+		Slots = Ch.slots;
+	} while (!__sync_bool_compare_and_swap(&Ch.slots, Slots, Slots & 3));
+
+	Free = (Slots & 3) == 1 ? 2 : 1;
+
+	Segment & Seg = Ch.segments[Free - 1];
+	for (unsigned int i = 0; i < Samples.size(); ++i) {
+		int Value = Samples[i];
+
+		if (Value < 0)
+			Value = 0;
+		else if (Value > 0x3FFF)
+			Value = 0x3FFF;
+
+		Seg.samples[i] = Value;
+	}
+	Seg.count = Samples.size();
+	Seg.mode = Mode;
+	Seg.divider = Divider;
+
+	//segment is complete before it is queued
+	do {
+		Slots = Ch.slots;
+	} while (!__sync_bool_compare_and_swap(&Ch.slots, Slots,
+			(Slots & 3) | (Free << 2)));
+
+	mutexLoad.unlock();
+
+	return 0;
+}
+
+void Waveform_player::stop(int Channel) {
+	int Slots;
+
+	if (Channel < 0 || Channel >= BOARD_DAC_CHANNELS)
+		return;
+
+	Waveform_player::Channel & Ch = channels[Channel];
+
+	mutexLoad.lock();
+
+	do {
+		Slots = Ch.slots;
+	} while (!__sync_bool_compare_and_swap(&Ch.slots, Slots, Slots & 3));
+
+	//played segment is released by the interface thread
+	if (Slots & 3)
+		__sync_lock_test_and_set(&Ch.stopRequest, 1);
+
+	mutexLoad.unlock();
+}
+
+bool Waveform_player::isPlaying(int Channel) {
+	if (Channel < 0 || Channel >= BOARD_DAC_CHANNELS)
+		return false;
+
+	const Waveform_player::Channel & Ch = channels[Channel];
+	int Slots = Ch.slots;
+
+	//a segment loaded after stop is started, the played one is
+	//released by the interface thread in the next tick
+	if (Slots >> 2)
+		return true;
+
+	return Slots != 0 && !Ch.stopRequest;
+}
+
+unsigned int Waveform_player::getCompleted(int Channel) {
+	if (Channel < 0 || Channel >= BOARD_DAC_CHANNELS)
+		return 0;
+
+	return channels[Channel].completed;
+}
+
+void Waveform_player::advance(Channel & Ch, bool Loop) {
+	int Slots, Next;
+
+	do {
+		Slots = Ch.slots;
+
+		if (Slots >> 2)
+			Next = Slots >> 2;
+		else
+			Next = Loop ? Slots & 3 : 0;
+	} while (!__sync_bool_compare_and_swap(&Ch.slots, Slots, Next));
+
+	Ch.position = 0;
+	Ch.wait = 0;
+}
+
+int Waveform_player::next(int * DAC) {
+	int Mask = 0;
+
+	for (int i = 0; i < BOARD_DAC_CHANNELS; ++i) {
+		Channel & Ch = channels[i];
+
+		if (Ch.slots == 0)
+			continue;
+
+		if (Ch.stopRequest && __sync_lock_test_and_set(&Ch.stopRequest, 0)) {
+			//queued segment was withdrawn by stop, one loaded
+			//afterwards is started
+			advance(Ch, false);
+			continue;
+		}
+
+		//idle channel starts the queued segment
+		if ((Ch.slots & 3) == 0)
+			advance(Ch, false);
+
+		int Played = Ch.slots & 3;
+		if (Played == 0)
+			continue;
+
+		if (Ch.wait > 0) {
+			--Ch.wait;
+			continue;
+		}
+
+		const Segment & Seg = Ch.segments[Played - 1];
+
+		DAC[i] = Seg.samples[Ch.position];
+		Mask |= 1 << i;
+
+		Ch.wait = Seg.divider - 1;
+
+		if (++Ch.position >= Seg.count) {
+			__sync_fetch_and_add(&Ch.completed, 1);
+
+			//next segment follows without a gap
+			unsigned int Wait = Ch.wait;
+			advance(Ch, Seg.mode == WAVEFORM_MODE_LOOP);
+			Ch.wait = Wait;
+		}
+	}
+
+	return Mask;
+}
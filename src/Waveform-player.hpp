@@ -0,0 +1,155 @@
+/**
+ * \file Waveform-player.hpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef WAVEFORM_PLAYER_HPP
+#define WAVEFORM_PLAYER_HPP
+
+#include <vector>
+
+#include <rtt/os/Mutex.hpp>
+
+#include "Board-backend.hpp"
+
+/**
+ * Maximal number of samples of a segment
+ */
+#define WAVEFORM_MAX_SAMPLES 4096
+
+#define WAVEFORM_MODE_ONESHOT 0
+#define WAVEFORM_MODE_LOOP 1
+
+/**
+ * \brief Waveform_player
+ *
+ * Plays waveforms on the DAC channels at the tick rate
+ * of the interface thread.
+ *
+ * Every channel has two segments. While one of them is played
+ * a new waveform is loaded into the other and queued, it starts
+ * right after the last sample of the played one, so waveforms are
+ * replaced without a gap. Which segment is played and which is queued
+ * is kept in a single word changed only with compare and swap,
+ * \link next next \endlink never blocks.
+ */
+class Waveform_player {
+public:
+
+	Waveform_player();
+
+	/**
+	 * \brief load
+	 *
+	 * Queues a waveform on the channel. Segment queued before and not
+	 * started yet is replaced. Called by non real-time threads.
+	 *
+	 * \param[in]	Channel		DAC channel 0-3
+	 * \param[in]	Samples		Values from 0 to 2^14 - 1, at most
+	 * 											WAVEFORM_MAX_SAMPLES of them
+	 * \param[in]	Mode			WAVEFORM_MODE_ONESHOT or WAVEFORM_MODE_LOOP
+	 * \param[in]	Divider		Number of ticks each sample is held
+	 *
+	 * \return		0 on success, -1 on bad arguments
+	 */
+	int load(int Channel, const std::vector<int> & Samples, int Mode,
+			int Divider);
+
+	/**
+	 * \brief stop
+	 *
+	 * Stops the channel after the current tick and drops
+	 * the queued segment. The last value stays on the output.
+	 */
+	void stop(int Channel);
+
+	/**
+	 * \return		true when a segment is played or queued,
+	 * 						false right after stop
+	 */
+	bool isPlaying(int Channel);
+
+	/**
+	 * \return		Number of segments of the channel played to the end
+	 */
+	unsigned int getCompleted(int Channel);
+
+	/**
+	 * \brief next
+	 *
+	 * Advances all the channels by one tick. Called only
+	 * by the interface thread.
+	 *
+	 * \param[out]	DAC		Values of the channels due in this tick
+	 *
+	 * \return		Mask of the channels written to DAC
+	 */
+	int next(int * DAC);
+
+private:
+
+	struct Segment {
+		int samples[WAVEFORM_MAX_SAMPLES];
+		unsigned int count;
+		int mode;
+		unsigned int divider;
+	};
+
+	struct Channel {
+		Segment segments[2];
+
+		/**
+		 * Bits 0-1 played and bits 2-3 queued segment,
+		 * 1 or 2 for segments[0] or segments[1], 0 for none
+		 */
+		volatile int slots;
+
+		volatile int stopRequest;
+
+		volatile unsigned int completed;
+
+		/**
+		 * Playing position, owned by the interface thread
+		 */
+		unsigned int position;
+
+		unsigned int wait;
+	};
+
+	/**
+	 * Starts the queued segment, or finishes the played one
+	 * when nothing is queued
+	 */
+	void advance(Channel & Ch, bool Loop);
+
+	Channel channels[BOARD_DAC_CHANNELS];
+
+	/**
+	 * Serializes loading of the channels
+	 */
+	RTT::os::Mutex mutexLoad;
+};
+
+#endif
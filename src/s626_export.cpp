@@ -0,0 +1,238 @@
+/**
+ * \file s626_export.cpp
+ *
+ * \author Wojciech Domski
+ *
+ * \brief Converts recordings of S626_task to CSV or NumPy arrays
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "Frame-codec.hpp"
+
+/**
+ * seq, cycle, timestamp, 3 valid masks, DIO, ADC and ENC
+ */
+#define EXPORT_COLUMNS (6 + BOARD_DIO_BANKS + BOARD_ADC_CHANNELS + BOARD_ENC_CHANNELS)
+
+namespace {
+
+void usage(void) {
+	std::cerr << "Usage: s626_export [--csv | --npy] <recording> <output>\n"
+			<< "Converts a recording of S626_task.startRecording,\n"
+			<< "one row per frame with columns:\n"
+			<< "seq, cycle, timestamp [ns], ADCValid, ENCValid, DIOValid,\n"
+			<< "DIO0-2, ADC0-15, ENC0-5\n";
+}
+
+/**
+ * Reads the encoded frames of the recording
+ */
+bool load(const char * Path, std::vector<unsigned char> & Data,
+		Record_header & Header) {
+	FILE * File = fopen(Path, "rb");
+
+	if (File == NULL) {
+		std::cerr << "Cannot open " << Path << "\n";
+		return false;
+	}
+
+	if (fread(&Header, sizeof(Header), 1, File) != 1
+			|| !checkRecordHeader(Header)) {
+		std::cerr << Path << " is not a recording\n";
+		fclose(File);
+		return false;
+	}
+
+	Data.resize(Header.used);
+
+	if (fseek(File, Header.size, SEEK_SET) != 0
+			|| (Header.used > 0
+					&& fread(&Data[0], Header.used, 1, File) != 1)) {
+		std::cerr << Path << " is truncated\n";
+		fclose(File);
+		return false;
+	}
+
+	fclose(File);
+
+	return true;
+}
+
+void row(const S626_frame & Frame, long long * Row) {
+	int Column = 0;
+
+	Row[Column++] = Frame.seq;
+	Row[Column++] = Frame.cycle;
+	Row[Column++] = Frame.timestamp;
+	Row[Column++] = Frame.ADCValid;
+	Row[Column++] = Frame.ENCValid;
+	Row[Column++] = Frame.DIOValid;
+
+	for (int i = 0; i < BOARD_DIO_BANKS; ++i)
+		Row[Column++] = Frame.DIO[i];
+	for (int i = 0; i < BOARD_ADC_CHANNELS; ++i)
+		Row[Column++] = Frame.ADC[i];
+	for (int i = 0; i < BOARD_ENC_CHANNELS; ++i)
+		Row[Column++] = Frame.ENC[i];
+}
+
+/**
+ * Decodes all the frames into rows
+ */
+bool decode(const std::vector<unsigned char> & Data,
+		std::vector<long long> & Rows) {
+	S626_frame Frame;
+	long long Row[EXPORT_COLUMNS];
+	size_t Offset = 0;
+	int Size;
+
+	memset(&Frame, 0, sizeof(Frame));
+
+	while (Offset < Data.size()) {
+		Size = decodeFrame(Frame, &Data[Offset], (int) (Data.size() - Offset));
+		if (Size < 0) {
+			std::cerr << "Recording is corrupted after " << Rows.size()
+					/ EXPORT_COLUMNS << " frames\n";
+			return false;
+		}
+		Offset += Size;
+
+		row(Frame, Row);
+		Rows.insert(Rows.end(), Row, Row + EXPORT_COLUMNS);
+	}
+
+	return true;
+}
+
+bool writeCSV(const char * Path, const std::vector<long long> & Rows) {
+	FILE * File = fopen(Path, "w");
+
+	if (File == NULL) {
+		std::cerr << "Cannot create " << Path << "\n";
+		return false;
+	}
+
+	fprintf(File, "seq,cycle,timestamp,ADCValid,ENCValid,DIOValid");
+	for (int i = 0; i < BOARD_DIO_BANKS; ++i)
+		fprintf(File, ",DIO%d", i);
+	for (int i = 0; i < BOARD_ADC_CHANNELS; ++i)
+		fprintf(File, ",ADC%d", i);
+	for (int i = 0; i < BOARD_ENC_CHANNELS; ++i)
+		fprintf(File, ",ENC%d", i);
+	fprintf(File, "\n");
+
+	for (size_t i = 0; i < Rows.size(); i += EXPORT_COLUMNS) {
+		for (int j = 0; j < EXPORT_COLUMNS; ++j)
+			fprintf(File, j ? ",%lld" : "%lld", Rows[i + j]);
+		fprintf(File, "\n");
+	}
+
+	return fclose(File) == 0;
+}
+
+/**
+ * NumPy .npy version 1.0 with a 2D little endian int64 array
+ */
+bool writeNPY(const char * Path, const std::vector<long long> & Rows) {
+	char Dict[128];
+	unsigned char Preamble[10] = { 0x93, 'N', 'U', 'M', 'P', 'Y', 1, 0, 0, 0 };
+	size_t Length;
+	FILE * File = fopen(Path, "wb");
+
+	if (File == NULL) {
+		std::cerr << "Cannot create " << Path << "\n";
+		return false;
+	}
+
+	snprintf(Dict, sizeof(Dict),
+			"{'descr': '<i8', 'fortran_order': False, 'shape': (%lu, %d), }",
+			(unsigned long) (Rows.size() / EXPORT_COLUMNS), EXPORT_COLUMNS);
+
+	//header is padded with spaces and ends with a newline,
+	//so the data starts aligned to 64 bytes
+	Length = strlen(Dict);
+	while ((sizeof(Preamble) + Length + 1) % 64 != 0)
+		Dict[Length++] = ' ';
+	Dict[Length++] = '\n';
+
+	Preamble[8] = (unsigned char) (Length & 0xFF);
+	Preamble[9] = (unsigned char) (Length >> 8);
+
+	fwrite(Preamble, sizeof(Preamble), 1, File);
+	fwrite(Dict, Length, 1, File);
+
+	//values are written byte by byte to be independent of the host
+	for (size_t i = 0; i < Rows.size(); ++i) {
+		unsigned char Value[8];
+		unsigned long long Raw = (unsigned long long) Rows[i];
+
+		for (int j = 0; j < 8; ++j)
+			Value[j] = (unsigned char) (Raw >> (8 * j));
+
+		fwrite(Value, sizeof(Value), 1, File);
+	}
+
+	return fclose(File) == 0;
+}
+
+}
+
+int main(int argc, char ** argv) {
+	bool NPY = false;
+	int Arg = 1;
+	Record_header Header;
+	std::vector<unsigned char> Data;
+	std::vector<long long> Rows;
+
+	if (Arg < argc && strcmp(argv[Arg], "--npy") == 0) {
+		NPY = true;
+		++Arg;
+	} else if (Arg < argc && strcmp(argv[Arg], "--csv") == 0)
+		++Arg;
+
+	if (argc - Arg != 2) {
+		usage();
+		return 1;
+	}
+
+	if (!load(argv[Arg], Data, Header))
+		return 1;
+
+	if (!decode(Data, Rows))
+		return 1;
+
+	if (!(NPY ? writeNPY(argv[Arg + 1], Rows) : writeCSV(argv[Arg + 1], Rows)))
+		return 1;
+
+	std::cout << Rows.size() / EXPORT_COLUMNS << " frames exported, "
+			<< Header.dropped << " dropped during recording\n";
+
+	return 0;
+}
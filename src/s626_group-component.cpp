@@ -0,0 +1,118 @@
+/**
+ * \file s626_group-component.cpp
+ *
+ * \author Wojciech Domski
+ *
+ * \brief Implementation of S626_group OROCOS component
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include "s626_group-component.hpp"
+#include <rtt/Component.hpp>
+#include <rtt/Logger.hpp>
+#include <iostream>
+#include <cstring>
+
+S626_group::S626_group(std::string const& name) :
+		TaskContext(name), TriggerOnFrame(false), Engine(NULL), PublishedSeq(0) {
+
+	this->addProperty("AcquisitionEngine", AcquisitionEngine).doc(
+			"Name of the acquisition engine of the boards");
+
+	this->addProperty("TriggerOnFrame", TriggerOnFrame).doc(
+			"Trigger the component after every cycle of the engine, requires non periodic activity");
+
+	this->addOperation("getMembers", &S626_group::getMembers, this,
+			RTT::OwnThread).doc("Get names of the boards in the order of frames");
+
+	this->ports()->addPort("GroupFrameOutputPort", GroupFrameOutputPort).doc(
+			"Output Port with frames of all the boards read in the same cycle.");
+
+	memset(&Frame, 0, sizeof(Frame));
+	GroupFrameOutputPort.setDataSample(Frame);
+
+	std::cout << "S626_group constructed !" << std::endl;
+}
+
+bool S626_group::startHook() {
+	if (TriggerOnFrame && this->getActivity()->isPeriodic()) {
+		RTT::log(RTT::Logger::Error) << getName()
+				<< ": TriggerOnFrame requires non periodic activity, use setPeriod(0)"
+				<< RTT::endlog();
+		return false;
+	}
+
+	Engine = Acquisition_engine::find(AcquisitionEngine);
+
+	if (Engine == NULL) {
+		std::cout << "Acquisition engine " << AcquisitionEngine
+				<< " does not exist, start the boards first\n";
+		return false;
+	}
+
+	if (TriggerOnFrame)
+		Engine->setTrigger(this->getActivity());
+
+	std::cout << "S626_group started !" << std::endl;
+
+	return true;
+}
+
+void S626_group::updateHook() {
+	Engine->getGroupFrame(Frame);
+
+	//triggered also by operations, publish only new frames
+	if (Frame.seq == PublishedSeq)
+		return;
+
+	PublishedSeq = Frame.seq;
+
+	GroupFrameOutputPort.write(Frame);
+}
+
+void S626_group::stopHook() {
+	Engine->setTrigger(NULL);
+
+	Acquisition_engine::release(Engine);
+	Engine = NULL;
+
+	std::cout << "S626_group stopped !" << std::endl;
+}
+
+std::vector<std::string> S626_group::getMembers(void) {
+	if (Engine)
+		return Engine->getMembers();
+
+	Acquisition_engine * Found = Acquisition_engine::find(AcquisitionEngine);
+	std::vector<std::string> Members;
+
+	if (Found) {
+		Members = Found->getMembers();
+		Acquisition_engine::release(Found);
+	}
+
+	return Members;
+}
+
+ORO_LIST_COMPONENT_TYPE(S626_group)
@@ -0,0 +1,98 @@
+/**
+ * \file s626_group-component.hpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef OROCOS_S626_GROUP_COMPONENT_HPP
+#define OROCOS_S626_GROUP_COMPONENT_HPP
+
+#include <rtt/RTT.hpp>
+
+#include <string>
+#include <vector>
+
+#include "Acquisition-engine.hpp"
+#include "s626_task-types.hpp"
+
+/**
+ * \brief S626_group
+ *
+ * Class for S626_group OROCOS component
+ *
+ * Publishes frames of all the boards serviced by one acquisition
+ * engine as a single S626_group_frame. The boards are S626_task
+ * components with the same AcquisitionEngine property, they have
+ * to be started before the group.
+ */
+class S626_group : public RTT::TaskContext{
+  public:
+
+    S626_group(std::string const& name);
+
+    bool startHook();
+    void updateHook();
+    void stopHook();
+
+    /**
+     * \brief getMembers
+     *
+     * \return		Names of the boards in the order of frames
+     * 						in S626_group_frame
+     */
+    std::vector<std::string> getMembers( void);
+
+  private:
+
+    /**
+     * Name of the engine of the boards
+     */
+    std::string AcquisitionEngine;
+
+    /**
+     * When true the engine triggers the component after every
+     * cycle, the component has to run in non periodic activity,
+     * otherwise it refuses to start
+     */
+    bool TriggerOnFrame;
+
+    Acquisition_engine * Engine;
+
+    S626_group_frame Frame;
+
+    /**
+     * Sequence number of the last published group frame
+     */
+    unsigned int PublishedSeq;
+
+    /**
+     * \brief GroupFrameOutputPort
+     *
+     * Frames of all the boards read in the same cycle
+     */
+    RTT::OutputPort<S626_group_frame> GroupFrameOutputPort;
+};
+
+#endif
@@ -0,0 +1,520 @@
+/**
+ * \file s626_task-bench.cpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include <rtt/os/main.h>
+#include <rtt/os/TimeService.hpp>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "s626_task-component.hpp"
+
+/**
+ * Cycles measured for each channel configuration
+ */
+#define BENCH_DEFAULT_ITERATIONS 20000
+
+#define BENCH_MAX_THREADS 8
+
+/**
+ * Writer components of the drain stress test
+ */
+#define BENCH_MAX_WRITERS 32
+
+/**
+ * Commands sent by each writer of the drain stress test
+ */
+#define BENCH_WRITER_COMMANDS 2000
+
+namespace {
+
+long long now(void) {
+	return RTT::os::TimeService::Instance()->getNSecs();
+}
+
+/**
+ * Summary of a set of samples in nanoseconds
+ */
+struct Summary {
+	long long count;
+	double mean;
+	long long min;
+	long long p50;
+	long long p99;
+	long long max;
+};
+
+Summary summarize(std::vector<long long> & Samples) {
+	Summary Result;
+	double Sum = 0.0;
+
+	memset(&Result, 0, sizeof(Result));
+	if (Samples.empty())
+		return Result;
+
+	std::sort(Samples.begin(), Samples.end());
+
+	for (size_t i = 0; i < Samples.size(); ++i)
+		Sum += Samples[i];
+
+	Result.count = Samples.size();
+	Result.mean = Sum / Samples.size();
+	Result.min = Samples.front();
+	Result.p50 = Samples[Samples.size() / 2];
+	Result.p99 = Samples[(Samples.size() * 99) / 100];
+	Result.max = Samples.back();
+
+	return Result;
+}
+
+void writeSummary(FILE * Output, const Summary & Result) {
+	fprintf(Output, "\"count\": %lld, \"mean_ns\": %.1f, \"min_ns\": %lld, "
+			"\"p50_ns\": %lld, \"p99_ns\": %lld, \"max_ns\": %lld", Result.count,
+			Result.mean, Result.min, Result.p50, Result.p99, Result.max);
+}
+
+/**
+ * Channel configuration of a step benchmark
+ */
+struct Step_config {
+	const char * name;
+	int state;
+	int ADC;
+	int ENC;
+};
+
+const Step_config StepConfigs[] = {
+		{ "idle", 0, 0, 0 },
+		{ "dio", INTERFACE_ACTIVITY_MASK_DIO, 0, 0 },
+		{ "enc6", INTERFACE_ACTIVITY_MASK_ENC, 0, 0x3F },
+		{ "adc1", INTERFACE_ACTIVITY_MASK_ADC, 0x0001, 0 },
+		{ "adc4", INTERFACE_ACTIVITY_MASK_ADC, 0x000F, 0 },
+		{ "adc16", INTERFACE_ACTIVITY_MASK_ADC, 0xFFFF, 0 },
+		{ "all", INTERFACE_ACTIVITY_MASK_ADC | INTERFACE_ACTIVITY_MASK_ENC
+				| INTERFACE_ACTIVITY_MASK_DIO, 0xFFFF, 0x3F }, };
+
+#define BENCH_STEP_CONFIGS (sizeof(StepConfigs) / sizeof(StepConfigs[0]))
+
+/**
+ * Cost of Interface_thread::step for every channel configuration,
+ * the thread is not started and step is called directly
+ */
+void benchStep(FILE * Output, int Iterations) {
+	Interface_thread * Interface = new Interface_thread(ORO_SCHED_OTHER, 0,
+			0.001, ~0u, "BenchInterface");
+	std::vector<long long> Samples;
+	long long Start;
+
+	Interface->setBackend(createBoardBackend("sim"));
+	Interface->resetDriver("sim", 0, 0);
+	Interface->prepareENC();
+	Interface->initialize();
+
+	Samples.reserve(Iterations);
+
+	fprintf(Output, "  \"step\": [\n");
+
+	for (unsigned int c = 0; c < BENCH_STEP_CONFIGS; ++c) {
+		Interface->setInitialADC(StepConfigs[c].ADC);
+		Interface->setInitialENC(StepConfigs[c].ENC);
+		Interface->setActivePublishing(StepConfigs[c].state);
+
+		//the first cycle rebuilds the frame of the backend
+		Interface->step();
+
+		Samples.clear();
+		for (int i = 0; i < Iterations; ++i) {
+			//outputs are staged as the component would do
+			Interface->setDAC(i & 3, i & 0x1FFF);
+
+			Start = now();
+			Interface->step();
+			Samples.push_back(now() - Start);
+		}
+
+		Summary Result = summarize(Samples);
+
+		fprintf(Output, "    { \"config\": \"%s\", \"adc_mask\": %d, "
+				"\"enc_mask\": %d, ", StepConfigs[c].name, StepConfigs[c].ADC,
+				StepConfigs[c].ENC);
+		writeSummary(Output, Result);
+		fprintf(Output, " }%s\n", c + 1 < BENCH_STEP_CONFIGS ? "," : "");
+
+		std::cout << "step " << StepConfigs[c].name << ": " << Result.mean
+				<< " ns\n";
+	}
+
+	fprintf(Output, "  ],\n");
+
+	Interface->stopDriver();
+	delete Interface;
+}
+
+/**
+ * Publishing cost of S626_task::updateHook with all the channels,
+ * the component must be stopped so its activity does not run the hook
+ */
+void benchUpdate(FILE * Output, S626_task & Task, int Iterations) {
+	std::vector<long long> Samples;
+	long long Start;
+
+	Samples.reserve(Iterations);
+
+	for (int i = 0; i < Iterations; ++i) {
+		Start = now();
+		Task.updateHook();
+		Samples.push_back(now() - Start);
+	}
+
+	Summary Result = summarize(Samples);
+
+	fprintf(Output, "  \"update_hook\": { ");
+	writeSummary(Output, Result);
+	fprintf(Output, " },\n");
+
+	std::cout << "updateHook: " << Result.mean << " ns\n";
+}
+
+struct Caller {
+	pthread_t thread;
+	S626_task * task;
+	int index;
+	int iterations;
+	volatile int * go;
+	std::vector<long long> samples;
+};
+
+void * call(void * Arg) {
+	Caller * Self = (Caller *) Arg;
+	long long Start;
+
+	while (!*Self->go)
+		;
+
+	for (int i = 0; i < Self->iterations; ++i) {
+		Start = now();
+		if (i & 1)
+			Self->task->writeDAC((Self->index + i) & 3, i & 0x1FFF);
+		else
+			Self->task->readADC((Self->index + i) & 15);
+		Self->samples.push_back(now() - Start);
+	}
+
+	return NULL;
+}
+
+/**
+ * Latency of readADC and writeDAC called concurrently by 1-8 threads
+ * while the interface thread acquires all the channels
+ */
+void benchContention(FILE * Output, S626_task & Task, int Iterations) {
+	std::vector<long long> Samples;
+
+	fprintf(Output, "  \"contention\": [\n");
+
+	for (int Threads = 1; Threads <= BENCH_MAX_THREADS; ++Threads) {
+		Caller Callers[BENCH_MAX_THREADS];
+		volatile int Go = 0;
+		long long Start, Wall;
+
+		for (int t = 0; t < Threads; ++t) {
+			Callers[t].task = &Task;
+			Callers[t].index = t;
+			Callers[t].iterations = Iterations;
+			Callers[t].go = &Go;
+			Callers[t].samples.reserve(Iterations);
+			pthread_create(&Callers[t].thread, NULL, call, &Callers[t]);
+		}
+
+		Start = now();
+		__sync_synchronize();
+		Go = 1;
+
+		Samples.clear();
+		for (int t = 0; t < Threads; ++t) {
+			pthread_join(Callers[t].thread, NULL);
+			Samples.insert(Samples.end(), Callers[t].samples.begin(),
+					Callers[t].samples.end());
+		}
+		Wall = now() - Start;
+
+		Summary Result = summarize(Samples);
+
+		fprintf(Output, "    { \"threads\": %d, \"calls_per_s\": %.0f, ", Threads,
+				Wall > 0 ? Result.count * 1e9 / Wall : 0.0);
+		writeSummary(Output, Result);
+		fprintf(Output, " }%s\n", Threads < BENCH_MAX_THREADS ? "," : "");
+
+		std::cout << "contention " << Threads << " threads: p99 " << Result.p99
+				<< " ns\n";
+	}
+
+	fprintf(Output, "  ],\n");
+}
+
+struct Writer {
+	pthread_t thread;
+	RTT::OutputPort<std::vector<int> > * port;
+	int index;
+	volatile int * go;
+	volatile int * finished;
+};
+
+void * produce(void * Arg) {
+	Writer * Self = (Writer *) Arg;
+	std::vector<int> Command(2);
+
+	while (!*Self->go)
+		;
+
+	//each writer drives its own channel, commands of writers
+	//sharing a channel are coalesced by the component
+	Command[0] = 1 << (Self->index % BOARD_DAC_CHANNELS);
+	for (int i = 0; i < BENCH_WRITER_COMMANDS; ++i) {
+		Command[1] = i & 0x1FFF;
+		Self->port->write(Command);
+
+		if ((i & 15) == 15)
+			sched_yield();
+	}
+
+	__sync_fetch_and_add(Self->finished, 1);
+
+	return NULL;
+}
+
+/**
+ * Throughput of DACInputPort read by updateHook with many writer
+ * components connected over buffers, the component is stopped
+ * and updateHook is called back to back
+ */
+void benchDrain(FILE * Output, S626_task & Task) {
+	RTT::base::PortInterface * Input = Task.ports()->getPort("DACInputPort");
+	const int Counts[] = { 1, 4, 16, BENCH_MAX_WRITERS };
+	const int Configs = sizeof(Counts) / sizeof(Counts[0]);
+	std::vector<long long> Samples;
+
+	fprintf(Output, "  \"drain\": [\n");
+
+	for (int c = 0; c < Configs; ++c) {
+		Writer Writers[BENCH_MAX_WRITERS];
+		volatile int Go = 0, Finished = 0;
+		int Count = Counts[c];
+		unsigned int Drained = 0;
+		long long Start, Wall;
+
+		for (int t = 0; t < Count; ++t) {
+			Writers[t].port = new RTT::OutputPort<std::vector<int> >("BenchWriter");
+			Writers[t].port->setDataSample(std::vector<int>(2));
+			Writers[t].port->connectTo(Input, RTT::ConnPolicy::buffer(64));
+			Writers[t].index = t;
+			Writers[t].go = &Go;
+			Writers[t].finished = &Finished;
+			pthread_create(&Writers[t].thread, NULL, produce, &Writers[t]);
+		}
+
+		Task.resetDrainStats();
+		Samples.clear();
+
+		Start = now();
+		__sync_synchronize();
+		Go = 1;
+
+		//read until the writers are done and the buffers are empty
+		do {
+			Drained = Task.getDrainStats(S626_DRAIN_DAC).drained;
+
+			long long Begin = now();
+			Task.updateHook();
+			Samples.push_back(now() - Begin);
+		} while (Finished < Count
+				|| Task.getDrainStats(S626_DRAIN_DAC).drained != Drained);
+
+		Wall = now() - Start;
+
+		for (int t = 0; t < Count; ++t) {
+			pthread_join(Writers[t].thread, NULL);
+			Writers[t].port->disconnect();
+			delete Writers[t].port;
+		}
+
+		S626_drain_stats Drain = Task.getDrainStats(S626_DRAIN_DAC);
+		Summary Result = summarize(Samples);
+
+		//commands not drained were rejected by full buffers
+		fprintf(Output, "    { \"writers\": %d, \"written\": %d, "
+				"\"drained\": %u, \"coalesced\": %u, \"dropped\": %u, "
+				"\"carried_cycles\": %u, \"budget\": %u, \"peak\": %u, "
+				"\"commands_per_s\": %.0f, \"update_hook\": { ", Count,
+				Count * BENCH_WRITER_COMMANDS, Drain.drained, Drain.coalesced,
+				Drain.dropped, Drain.carriedCycles, Drain.budget, Drain.peak,
+				Wall > 0 ? Drain.drained * 1e9 / Wall : 0.0);
+		writeSummary(Output, Result);
+		fprintf(Output, " } }%s\n", c + 1 < Configs ? "," : "");
+
+		std::cout << "drain " << Count << " writers: " << Drain.drained
+				<< " of " << Count * BENCH_WRITER_COMMANDS << " commands\n";
+	}
+
+	fprintf(Output, "  ],\n");
+}
+
+/**
+ * Waits until the board is opened by the driver thread
+ */
+bool waitDriver(S626_task & Task) {
+	int State;
+
+	while ((State = Task.getDriverState()) == DRIVER_STATE_OPENING
+			|| State == DRIVER_STATE_CLOSING)
+		sched_yield();
+
+	return State == DRIVER_STATE_OPEN;
+}
+
+/**
+ * Wall time of prepareDriver, until the board is open,
+ * and of prepareAllENC
+ */
+void benchPrepare(FILE * Output, S626_task & Task) {
+	std::vector<long long> Request, Driver, ENC;
+	long long Start;
+
+	for (int i = 0; i < 10; ++i) {
+		Start = now();
+		Task.prepareDriver("sim", 0, 0);
+		Request.push_back(now() - Start);
+		waitDriver(Task);
+		Driver.push_back(now() - Start);
+
+		Start = now();
+		Task.prepareAllENC();
+		ENC.push_back(now() - Start);
+	}
+
+	fprintf(Output, "  \"prepare_driver_request\": { ");
+	writeSummary(Output, summarize(Request));
+	fprintf(Output, " },\n  \"prepare_driver\": { ");
+	writeSummary(Output, summarize(Driver));
+	fprintf(Output, " },\n  \"prepare_all_enc\": { ");
+	writeSummary(Output, summarize(ENC));
+	fprintf(Output, " }\n");
+}
+
+}
+
+int ORO_main(int argc, char ** argv) {
+	const char * Path = "s626_task-bench.json";
+	int Iterations = BENCH_DEFAULT_ITERATIONS;
+
+	if (argc > 1 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0)) {
+		std::cerr << "Usage: s626_task-bench [output.json] [iterations]\n"
+				<< "Measures the acquisition and publishing paths against\n"
+				<< "the simulated board and writes the results as JSON\n";
+		return 1;
+	}
+
+	if (argc > 1)
+		Path = argv[1];
+	if (argc > 2)
+		Iterations = atoi(argv[2]);
+	if (Iterations <= 0)
+		Iterations = BENCH_DEFAULT_ITERATIONS;
+
+	FILE * Output = fopen(Path, "w");
+	if (Output == NULL) {
+		std::cerr << "Can not open " << Path << "\n";
+		return 1;
+	}
+
+	fprintf(Output, "{\n  \"iterations\": %d,\n", Iterations);
+
+	benchStep(Output, Iterations);
+
+	S626_task Task("BenchTask");
+
+	//real-time priorities of the properties are not used, configure
+	//applies the ones set here
+	Task.setInterfacePriority(ORO_SCHED_OTHER, 0);
+
+	//starts the driver thread serving the requests below
+	if (!Task.configure()) {
+		std::cerr << "Can not configure the component\n";
+		fclose(Output);
+		return 1;
+	}
+
+	Task.selectBackend("sim");
+	Task.prepareDriver("sim", 0, 0);
+	Task.prepareAllENC();
+
+	if (!waitDriver(Task)) {
+		std::cerr << "Can not open the simulated board\n";
+		fclose(Output);
+		return 1;
+	}
+
+	Task.setInitialADC(0xFFFF);
+	Task.setInitialENC(0x3F);
+	Task.setActivePublishing(
+			INTERFACE_ACTIVITY_MASK_ADC | INTERFACE_ACTIVITY_MASK_ENC
+					| INTERFACE_ACTIVITY_MASK_DIO);
+
+	if (!Task.start()) {
+		std::cerr << "Can not start the component\n";
+		fclose(Output);
+		return 1;
+	}
+
+	benchContention(Output, Task, Iterations);
+
+	Task.stop();
+
+	benchUpdate(Output, Task, Iterations);
+
+	benchDrain(Output, Task);
+
+	benchPrepare(Output, Task);
+
+	fprintf(Output, "}\n");
+	fclose(Output);
+
+	Task.cleanup();
+
+	std::cout << "Results written to " << Path << "\n";
+
+	return 0;
+}
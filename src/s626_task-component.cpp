@@ -29,16 +29,23 @@
 
 #include "s626_task-component.hpp"
 #include <rtt/Component.hpp>
+#include <rtt/Logger.hpp>
 #include <iostream>
 #include <vector>
-#include <native/timer.h>
+#include <cstring>
 
-#include "S626API.h"
+#include "Sim-backend.hpp"
+#include "Replay-backend.hpp"
 
 S626_task::S626_task(std::string const& name) :
-		TaskContext(name), err(0), Device("analogy0"), Bus(0), Slot(0), state(0) {
-
-	this->addOperation("readDIO", &S626_task::readDIO, this, RTT::OwnThread).doc(
+		TaskContext(name), Device("analogy0"), Bus(0), Slot(0), state(0), StatsPeriod(
+				1.0), StatsPublished(0), TriggerOnFrame(false), PublishedSeq(0), DataAge(
+				0.0), DrainBudgetMax(S626_TASK_DRAIN_BUDGET_MAX), DrainTime(0.0), PublishMode(
+				S626_TASK_PUBLISH_ALL), Heartbeat(1.0), ChangesReset(true) {
+
+	//latest values are taken from the frame snapshot without
+	//queueing behind updateHook
+	this->addOperation("readDIO", &S626_task::readDIO, this, RTT::ClientThread).doc(
 			"Read digital input").arg("Bank", "Bank number 0-2");
 
 	this->addOperation("writeDIO", &S626_task::writeDIO, this, RTT::OwnThread).doc(
@@ -46,9 +53,19 @@ S626_task::S626_task(std::string const& name) :
 			"Mask for bits to be written").arg("Value",
 			"Value on specific bit position");
 
-	this->addOperation("readADC", &S626_task::readADC, this, RTT::OwnThread).doc(
+	this->addOperation("readADC", &S626_task::readADC, this, RTT::ClientThread).doc(
 			"Read analog value").arg("Channel", "Channel to be read 0-15");
 
+	this->addOperation("readAllADC", &S626_task::readAllADC, this,
+			RTT::ClientThread).doc(
+			"Read selected analog values from the same frame").arg("Mask",
+			"Channel selector");
+
+	this->addOperation("readAllENC", &S626_task::readAllENC, this,
+			RTT::ClientThread).doc(
+			"Read selected encoders from the same frame").arg("Mask",
+			"Encoder selector");
+
 	this->addOperation("setrangeADC", &S626_task::setrangeADC, this,
 			RTT::OwnThread).doc("Set range of ADC").arg("Mask",
 			"Mask for bits to be written").arg("Value",
@@ -58,13 +75,53 @@ S626_task::S626_task(std::string const& name) :
 			"Write analog output").arg("Channel", "Channel to be written 0-3").arg(
 			"Value", "Value to be written");
 
+	this->addOperation("writeDACs", &S626_task::writeDACs, this,
+			RTT::OwnThread).doc("Write selected analog outputs at once").arg(
+			"Mask", "Channel selector").arg("Values",
+			"Values of the selected channels in ascending order");
+
+	this->addOperation("writeDIOBanks", &S626_task::writeDIOBanks, this,
+			RTT::OwnThread).doc("Write digital outputs of all banks at once").arg(
+			"Masks", "Bits to be written of banks 0-2").arg("Values",
+			"Value of each bank");
+
+	this->addOperation("loadWaveform", &S626_task::loadWaveform, this,
+			RTT::OwnThread).doc(
+			"Upload waveform played on DAC channel by the interface thread").arg(
+			"Channel", "Channel 0-3").arg("Samples",
+			"Values from 0 to 2^14 - 1, at most 4096").arg("Mode",
+			"0 - once, 1 - loop").arg("Divider",
+			"Number of interface periods each sample is held");
+
+	this->addOperation("stopWaveform", &S626_task::stopWaveform, this,
+			RTT::OwnThread).doc("Stop waveform on DAC channel").arg("Channel",
+			"Channel 0-3");
+
+	this->addOperation("isWaveformPlaying", &S626_task::isWaveformPlaying,
+			this, RTT::ClientThread).doc(
+			"Check whether waveform is played or queued on DAC channel").arg(
+			"Channel", "Channel 0-3");
+
+	this->addOperation("getWaveformSegments", &S626_task::getWaveformSegments,
+			this, RTT::ClientThread).doc(
+			"Get number of waveforms played to the end on DAC channel").arg(
+			"Channel", "Channel 0-3");
+
 	this->addOperation("getLastError", &S626_task::getLastError, this,
 			RTT::OwnThread).doc("Gets lats error and clears it");
 
+	this->addOperation("getErrorCount", &S626_task::getErrorCount, this,
+			RTT::OwnThread).doc("Get number of failures of a peripheral").arg(
+			"Peripheral", "0 - ADC, 1 - DAC, 2 - ENC, 3 - DIO, 4 - whole board").arg(
+			"Channel", "Channel or bank, -1 for all");
+
+	this->addOperation("resetErrorCounts", &S626_task::resetErrorCounts, this,
+			RTT::OwnThread).doc("Clear failure counters");
+
 	this->addOperation("prepareAllENC", &S626_task::prepareAllENC, this,
 			RTT::OwnThread).doc("Prepare all encoders");
 
-	this->addOperation("readENC", &S626_task::readENC, this, RTT::OwnThread).doc(
+	this->addOperation("readENC", &S626_task::readENC, this, RTT::ClientThread).doc(
 			"Read encoder").arg("Enc", "Specific encoder 0-5");
 
 	this->addOperation("setActivePublishing", &S626_task::setActivePublishing,
@@ -102,30 +159,355 @@ S626_task::S626_task(std::string const& name) :
 	this->ports()->addPort("ENCOutputPort", ENCOutputPort).doc(
 			"Output Port for ENC.");
 
+	this->ports()->addPort("FrameOutputPort", FrameOutputPort).doc(
+			"Output Port with the whole acquired frame.");
+
+	this->ports()->addPort("StatsOutputPort", StatsOutputPort).doc(
+			"Output Port with timing of the interface thread.");
+
+	this->ports()->addPort("DataAgeOutputPort", DataAgeOutputPort).doc(
+			"Output Port with age of the published frame in seconds.");
+
+	this->ports()->addPort("DIOEdgeOutputPort", DIOEdgeOutputPort).doc(
+			"Output Port with changes of DIO inputs.");
+
+	this->ports()->addPort("ADCChangeOutputPort", ADCChangeOutputPort).doc(
+			"Output Port with changed ADC channels.");
+
+	this->ports()->addPort("ENCChangeOutputPort", ENCChangeOutputPort).doc(
+			"Output Port with changed ENC channels.");
+
+	this->addProperty("PublishMode", PublishMode).doc(
+			"0 - all channels every cycle, 1 - only changed channels on change ports");
+
+	this->addProperty("Heartbeat", Heartbeat).doc(
+			"Longest time in seconds a channel is not published in change mode, 0 disables it");
+
+	this->addOperation("setDeadbandADC", &S626_task::setDeadbandADC, this,
+			RTT::OwnThread).doc("Set deadband of ADC channels in change publishing mode").arg(
+			"Mask", "Channel selector").arg("Threshold", "Deadband in raw units");
+
+	this->addOperation("setDeadbandENC", &S626_task::setDeadbandENC, this,
+			RTT::OwnThread).doc("Set deadband of ENC channels in change publishing mode").arg(
+			"Mask", "Channel selector").arg("Threshold", "Deadband in raw units");
+
+	this->addProperty("TriggerOnFrame", TriggerOnFrame).doc(
+			"Trigger the component after every acquired frame, requires non periodic activity");
+
+	this->addProperty("WatchdogFailures", WatchdogFailures).doc(
+			"Number of consecutive failed cycles after which the board is re-attached, 0 disables it");
+
+	this->addProperty("StatsPeriod", StatsPeriod).doc(
+			"Period of publishing timing statistics in seconds, 0 disables it");
+
+	this->addProperty("DrainBudgetMax", DrainBudgetMax).doc(
+			"Maximal number of commands read from an input port in one cycle");
+
+	this->addProperty("DrainTime", DrainTime).doc(
+			"Time for reading input ports in one cycle in seconds, 0 uses half of the period");
+
+	this->addOperation("getDrainStats", &S626_task::getDrainStats, this,
+			RTT::OwnThread).doc("Get accounting of commands read from an input port").arg(
+			"Port", "0 - DIOInputPortWrite, 1 - DACInputPort");
+
+	this->addOperation("getRisingEdges", &S626_task::getRisingEdges, this,
+			RTT::OwnThread).doc("Get number of rising edges of each bit of a DIO bank").arg(
+			"Bank", "Bank number 0-2");
+
+	this->addOperation("getFallingEdges", &S626_task::getFallingEdges, this,
+			RTT::OwnThread).doc("Get number of falling edges of each bit of a DIO bank").arg(
+			"Bank", "Bank number 0-2");
+
+	this->addOperation("resetEdgeCounts", &S626_task::resetEdgeCounts, this,
+			RTT::OwnThread).doc("Clear edge counters of DIO inputs");
+
+	this->addOperation("getLostEdges", &S626_task::getLostEdges, this,
+			RTT::OwnThread).doc("Get number of edge events which were not published");
+
+	this->addOperation("resetDrainStats", &S626_task::resetDrainStats, this,
+			RTT::OwnThread).doc("Clear accounting of input ports");
+
+	this->addOperation("getCycleStats", &S626_task::getCycleStats, this,
+			RTT::OwnThread).doc("Get timing of the interface thread");
+
+	this->addOperation("getCyclePercentile", &S626_task::getCyclePercentile,
+			this, RTT::OwnThread).doc(
+			"Get percentile of a stage duration of the interface thread in ns").arg(
+			"Stage", "0 - wake-up latency, 1 - frame read, 2 - ADC scan, 3 - step").arg(
+			"Percentile", "0-100");
+
+	this->addOperation("resetCycleStats", &S626_task::resetCycleStats, this,
+			RTT::OwnThread).doc("Clear timing of the interface thread");
+
 	this->addOperation("prepareDriver", &S626_task::prepareDriver, this,
 			RTT::OwnThread).doc("Prepare driver").arg("Device",
 			"Analogy device, ex. analogy0").arg("Bus", "Bus number").arg("Slot",
 			"Slot number");
 
+	this->addOperation("closeDriver", &S626_task::closeDriver, this,
+			RTT::OwnThread).doc("Close driver");
+
+	this->addOperation("getDriverState", &S626_task::getDriverState, this,
+			RTT::OwnThread).doc(
+			"Get state of the driver: 0 - closed, 1 - opening, 2 - open, 3 - closing, 4 - failed, 5 - recovering");
+
+	this->addOperation("getDriverRecoveries", &S626_task::getDriverRecoveries,
+			this, RTT::OwnThread).doc(
+			"Get number of times the board was re-attached by the watchdog");
+
+	this->addOperation("setADCMode", &S626_task::setADCMode, this,
+			RTT::OwnThread).doc("Select ADC acquisition mode").arg("Mode",
+			"0 - on demand conversion, 1 - hardware timed scan").arg("Period",
+			"Time between hardware scans in seconds");
+
+	this->addOperation("selectBackend", &S626_task::selectBackend, this,
+			RTT::OwnThread).doc("Select board backend").arg("Backend",
+			"analogy, sim or replay");
+
+	this->addOperation("setSimulatedLatency", &S626_task::setSimulatedLatency,
+			this, RTT::OwnThread).doc(
+			"Set latency of every call to the simulated board").arg("Latency",
+			"Latency in nanoseconds");
+
+	this->addOperation("injectSimulatedError", &S626_task::injectSimulatedError,
+			this, RTT::OwnThread).doc(
+			"Make next calls to the simulated board fail").arg("Peripheral",
+			"0 - ADC, 1 - DAC, 2 - ENC, 3 - DIO").arg("Channel",
+			"Channel or bank, -1 for all").arg("Error", "Error code").arg(
+			"Count", "Number of failing calls");
+
+	this->addOperation("setReplayMode", &S626_task::setReplayMode, this,
+			RTT::OwnThread).doc("Set speed of the replayed session").arg("Mode",
+			"0 - real time, 1 - scaled, 2 - as fast as possible").arg("Speed",
+			"Speed factor of scaled mode");
+
+	this->addOperation("rewindReplay", &S626_task::rewindReplay, this,
+			RTT::OwnThread).doc("Start the replayed session from the beginning");
+
+	this->addOperation("isReplayFinished", &S626_task::isReplayFinished, this,
+			RTT::OwnThread).doc("Check if the whole session was replayed");
+
+	this->addOperation("saveReplayCapture", &S626_task::saveReplayCapture,
+			this, RTT::OwnThread).doc(
+			"Save DAC and DIO writes issued during replay as CSV").arg("File",
+			"Path of the CSV file");
+
 	SelectedADCChannels = 0;
 	SelectedENCChannels = 0;
 
-	//create thread
-	Interface = new Interface_thread(ORO_SCHED_RT, 10, 0.001, 1,
-			"SensorayInterface");
+	DataDIORead.reserve(BOARD_DIO_BANKS);
+	DataADC.reserve(BOARD_ADC_CHANNELS);
+	DataENC.reserve(BOARD_ENC_CHANNELS);
+	//bank selector and pairs of mask and value
+	DataDIOWrite.reserve(1 + 2 * BOARD_DIO_BANKS);
+	//channel selector and values
+	DataDAC.reserve(1 + BOARD_DAC_CHANNELS);
+
+	memset(&Frame, 0, sizeof(Frame));
+	FrameOutputPort.setDataSample(Frame);
+
+	memset(&Stats, 0, sizeof(Stats));
+	StatsOutputPort.setDataSample(Stats);
+
+	memset(DrainStats, 0, sizeof(DrainStats));
+	for (int i = 0; i < S626_DRAIN_PORTS; ++i) {
+		DrainStats[i].budget = S626_TASK_DRAIN_BUDGET_MIN;
+		DrainHeld[i] = false;
+	}
+
+	DataAgeOutputPort.setDataSample(DataAge);
+
+	memset(&Edge, 0, sizeof(Edge));
+	DIOEdgeOutputPort.setDataSample(Edge);
+
+	for (int i = 0; i < BOARD_ADC_CHANNELS; ++i) {
+		DeadbandADC[i] = 0;
+		PublishedADC[i] = 0;
+		SentADC[i] = 0;
+	}
+	for (int i = 0; i < BOARD_ENC_CHANNELS; ++i) {
+		DeadbandENC[i] = 0;
+		PublishedENC[i] = 0;
+		SentENC[i] = 0;
+	}
+
+	memset(&UpdateADC, 0, sizeof(UpdateADC));
+	ADCChangeOutputPort.setDataSample(UpdateADC);
+	memset(&UpdateENC, 0, sizeof(UpdateENC));
+	ENCChangeOutputPort.setDataSample(UpdateENC);
+
+	prepareSamples();
+
+	this->addProperty("InterfaceScheduler", InterfaceScheduler).doc(
+			"Scheduler of the interface thread, ORO_SCHED_RT or ORO_SCHED_OTHER");
+
+	this->addProperty("InterfacePriority", InterfacePriority).doc(
+			"Priority of the interface thread");
+
+	this->addProperty("InterfacePeriod", InterfacePeriod).doc(
+			"Period of the interface thread in seconds");
+
+	this->addProperty("InterfaceCpuAffinity", InterfaceCpuAffinity).doc(
+			"Mask of CPUs the interface thread may run on");
+
+	this->addProperty("AcquisitionEngine", AcquisitionEngine).doc(
+			"Name of the thread shared with other boards, empty runs own interface thread");
+
+	this->addOperation("setRateDivider", &S626_task::setRateDivider, this,
+			RTT::OwnThread).doc(
+			"Read selected channels only every Divider-th cycle of the interface thread").arg(
+			"Peripheral", "0 - ADC, 2 - ENC, 3 - DIO").arg("Mask",
+			"Channels or banks affected").arg("Divider", "1 reads in every cycle");
+
+	this->addOperation("setInterfacePeriod", &S626_task::setInterfacePeriod,
+			this, RTT::OwnThread).doc(
+			"Change period of the interface thread, also while running, false when an acquisition engine owns it").arg(
+			"Period", "Period in seconds");
+
+	this->addOperation("setInterfacePriority",
+			&S626_task::setInterfacePriority, this, RTT::OwnThread).doc(
+			"Change scheduler and priority of the interface thread").arg(
+			"Scheduler", "ORO_SCHED_RT or ORO_SCHED_OTHER").arg("Priority",
+			"Priority");
+
+	this->addOperation("setInterfaceCpuAffinity",
+			&S626_task::setInterfaceCpuAffinity, this, RTT::OwnThread).doc(
+			"Change CPUs of the interface thread").arg("CpuAffinity",
+			"Mask of CPUs, bit 0 is CPU 0");
+
+	this->addOperation("getAchievableRate", &S626_task::getAchievableRate, this,
+			RTT::OwnThread).doc(
+			"Get maximal rate of the interface thread in Hz estimated from measured step duration");
+
+	this->addOperation("startRecording", &S626_task::startRecording, this,
+			RTT::OwnThread).doc(
+			"Record every frame of the interface thread into a binary file").arg(
+			"File", "Path of the recording").arg("Size",
+			"Size of the preallocated file in MB");
+
+	this->addOperation("stopRecording", &S626_task::stopRecording, this,
+			RTT::OwnThread).doc("Close the recording");
+
+	this->addOperation("startSharedMemory", &S626_task::startSharedMemory,
+			this, RTT::OwnThread).doc(
+			"Publish every frame into a POSIX shared memory segment").arg("Name",
+			"Name of the segment, empty for /<component name>");
+
+	this->addOperation("stopSharedMemory", &S626_task::stopSharedMemory, this,
+			RTT::OwnThread).doc("Remove the shared memory segment");
+
+	this->addOperation("getRecordedFrames", &S626_task::getRecordedFrames,
+			this, RTT::OwnThread).doc(
+			"Get number of frames in the current or last recording");
+
+	this->addOperation("getDroppedFrames", &S626_task::getDroppedFrames, this,
+			RTT::OwnThread).doc(
+			"Get number of frames missing in the current or last recording");
+
+	InterfaceScheduler = ORO_SCHED_RT;
+	InterfacePriority = 10;
+	InterfacePeriod = 0.001;
+	InterfaceCpuAffinity = 1;
+	Engine = NULL;
+	WatchdogFailures = 10;
+
+	//failures are logged by a low priority thread while running
+	Log = new Diag_log(0.1, name);
+
+	//create thread, properties are applied in configureHook
+	Interface = new Interface_thread(InterfaceScheduler, InterfacePriority,
+			InterfacePeriod, InterfaceCpuAffinity, "SensorayInterface");
+	Interface->setDiagLog(Log);
+
+	//board is opened and recovered without blocking the acquisition,
+	//requests made before configureHook are served once it runs
+	Driver = new Driver_manager(Interface, 0.01, "SensorayDriver");
+
+	//recorder thread runs only while recording
+	Recorder = new Frame_recorder(0.01, "SensorayRecorder");
+	Interface->setRecorder(Recorder);
+
+	//segment is mapped only while exported
+	SharedMemory = new Frame_shm_writer();
+	Interface->setSharedMemory(SharedMemory);
 
 	std::cout << "S626_task constructed !" << std::endl;
 
 }
 
+S626_task::~S626_task() {
+	//a running engine would still service the board
+	if (Engine)
+		Acquisition_engine::detach(Engine, Interface);
+
+	//threads are deleted before the objects they use
+	delete Driver;
+
+	delete Interface;
+
+	stopRecording();
+
+	delete Recorder;
+
+	delete Log;
+
+	delete SharedMemory;
+}
+
 bool S626_task::configureHook() {
+	prepareSamples();
+
+	if (!setInterfacePriority(InterfaceScheduler, InterfacePriority))
+		return false;
+
+	setInterfaceCpuAffinity(InterfaceCpuAffinity);
+
+	if (!setInterfacePeriod(InterfacePeriod))
+		return false;
+
+	if (!Driver->isActive() && !Driver->start())
+		return false;
+
 	std::cout << "S626_task configured !" << std::endl;
 	return true;
 }
 
 bool S626_task::startHook() {
 
-	Interface->start();
+	//also when started without being configured
+	if (!Driver->isActive() && !Driver->start())
+		return false;
+
+	if (TriggerOnFrame) {
+		if (this->getActivity()->isPeriodic()) {
+			RTT::log(RTT::Logger::Error) << getName()
+					<< ": TriggerOnFrame requires non periodic activity, use setPeriod(0)"
+					<< RTT::endlog();
+			return false;
+		}
+
+		Interface->setTrigger(this->getActivity());
+	} else
+		Interface->setTrigger(NULL);
+
+	Log->start();
+
+	Interface->setWatchdog(WatchdogFailures);
+
+	if (AcquisitionEngine.empty())
+		Interface->start();
+	else {
+		//the first board creates the engine with its interface settings
+		Engine = Acquisition_engine::attach(AcquisitionEngine, getName(),
+				Interface, InterfaceScheduler, InterfacePriority,
+				InterfacePeriod, InterfaceCpuAffinity);
+
+		if (Engine == NULL) {
+			std::cout << "Acquisition engine " << AcquisitionEngine
+					<< " services too many boards\n";
+			return false;
+		}
+	}
 
 	std::cout << "Driver prepared, s626 ready\n" << "S626_task started !\n";
 
@@ -137,7 +519,7 @@ int S626_task::prepareDriver(std::string nDevice, int nBus, int nSlot) {
 	Bus = nBus;
 	Slot = nSlot;
 
-	Interface->resetDriver(nDevice, nBus, nSlot);
+	Driver->requestOpen(nDevice, nBus, nSlot);
 
 	return 0;
 }
@@ -145,87 +527,347 @@ int S626_task::prepareDriver(std::string nDevice, int nBus, int nSlot) {
 void S626_task::updateHook() {
 	//std::cout << "S626_task executes updateHook !" <<std::endl;
 
-	std::vector<int> DataDAC;
-	std::vector<int> DataDIO;
-	std::vector<int> v;
-	int Channels, Banks;
+	RTT::os::TimeService::nsecs Deadline = 0;
+	double Time = DrainTime;
+
+	//input ports are read for a part of the cycle at most
+	if (Time <= 0.0 && this->getActivity() && this->getActivity()->isPeriodic())
+		Time = 0.5 * this->getActivity()->getPeriod();
+	if (Time > 0.0)
+		Deadline = RTT::os::TimeService::Instance()->getNSecs()
+				+ (RTT::os::TimeService::nsecs) (Time * 1e9);
+
+	//writes are only staged, Interface_thread merges them
+	//and writes the latest ones in its next cycle
+	drainDIO(Deadline);
+	drainDAC(Deadline);
+
+	//edges are published in the order they were detected,
+	//also those of frames skipped by this component
+	while (Interface->popEdge(Edge))
+		DIOEdgeOutputPort.write(Edge);
+
+	//read data from interface and redirect it to output ports
+	//single snapshot of all peripherals
+	Interface->getFrame(Frame);
+
+	//triggered also by operations and ports, publish only new frames
+	if (TriggerOnFrame && Frame.seq == PublishedSeq)
+		return;
+
+	PublishedSeq = Frame.seq;
+
+	//interface reading a backlog waits for this frame to be taken
+	Interface->acknowledge(Frame.seq);
+
+	DataAge = (RTT::os::TimeService::Instance()->getNSecs() - Frame.timestamp)
+			* 1e-9;
+	DataAgeOutputPort.write(DataAge);
+
+	FrameOutputPort.write(Frame);
+
+	//samples are sized in prepareSamples, only values are copied
+	//dio
+	for(int i = 0; i < 3; ++i)
+	{
+		DataDIORead[i] = Frame.DIO[i];
+	}
+	DIOOutputPortRead.write(DataDIORead);
+
+	if (PublishMode == S626_TASK_PUBLISH_CHANGES)
+		publishChanges();
+	else {
+		//changes are published against the latest values
+		//after switching the mode
+		ChangesReset = true;
+
+		//adc
+		for(unsigned int j = 0; j < DataADC.size(); ++j)
+		{
+			DataADC[j] = Frame.ADC[ADCIndex[j]];
+		}
+		ADCOutputPort.write(DataADC);
+
+		//enc
+		for(unsigned int j = 0; j < DataENC.size(); ++j)
+		{
+			DataENC[j] = Frame.ENC[ENCIndex[j]];
+		}
+		ENCOutputPort.write(DataENC);
+	}
+
+	//timing statistics at low rate
+	if (StatsPeriod > 0.0) {
+		RTT::os::TimeService::nsecs Now =
+				RTT::os::TimeService::Instance()->getNSecs();
+
+		if (Now - StatsPublished >= (RTT::os::TimeService::nsecs) (StatsPeriod * 1e9)) {
+			StatsPublished = Now;
+
+			Interface->getCycleStats(Stats);
+			StatsOutputPort.write(Stats);
+		}
+	}
+
+}
+
+int S626_task::changed(const int * Values, int * Published,
+		const int * Deadband, RTT::os::TimeService::nsecs * Sent, int Count,
+		int Selected, RTT::os::TimeService::nsecs Now,
+		RTT::os::TimeService::nsecs Silence) {
+	int Exceeded[BOARD_ADC_CHANNELS];
+	int Mask = 0;
+
+	//branch free pass over all the channels, vectorised by the compiler
+	for (int i = 0; i < Count; ++i) {
+		int Difference = Values[i] - Published[i];
+		int Magnitude = Difference < 0 ? -Difference : Difference;
+
+		Exceeded[i] = (Magnitude > Deadband[i]) | (Now - Sent[i] >= Silence);
+	}
+
+	for (int i = 0; i < Count; ++i)
+		Mask |= Exceeded[i] << i;
+
+	Mask &= Selected;
+
+	for (int i = 0; i < Count; ++i) {
+		if (Mask & (1 << i)) {
+			Published[i] = Values[i];
+			Sent[i] = Now;
+		}
+	}
+
+	return Mask;
+}
+
+void S626_task::publishChanges(void) {
+	RTT::os::TimeService::nsecs Now = RTT::os::TimeService::Instance()->getNSecs();
+	RTT::os::TimeService::nsecs Silence;
+	int ADCMask, ENCMask;
+
+	//disabled heartbeat never expires
+	if (Heartbeat > 0.0)
+		Silence = (RTT::os::TimeService::nsecs) (Heartbeat * 1e9);
+	else
+		Silence = 0x7FFFFFFFFFFFFFFFLL;
+
+	//first update after a change of configuration
+	//carries all the selected channels
+	if (ChangesReset) {
+		ChangesReset = false;
+		Silence = 0;
+	}
+
+	ADCMask = changed(Frame.ADC, PublishedADC, DeadbandADC, SentADC,
+			BOARD_ADC_CHANNELS, SelectedADCChannels, Now, Silence);
+	ENCMask = changed(Frame.ENC, PublishedENC, DeadbandENC, SentENC,
+			BOARD_ENC_CHANNELS, SelectedENCChannels, Now, Silence);
+
+	if (ADCMask) {
+		UpdateADC.seq = Frame.seq;
+		UpdateADC.timestamp = Frame.timestamp;
+		UpdateADC.count = 0;
+
+		for (int i = 0; i < BOARD_ADC_CHANNELS; ++i) {
+			if (ADCMask & (1 << i)) {
+				UpdateADC.channel[UpdateADC.count] = i;
+				UpdateADC.value[UpdateADC.count] = Frame.ADC[i];
+				++UpdateADC.count;
+			}
+		}
+
+		ADCChangeOutputPort.write(UpdateADC);
+	}
+
+	if (ENCMask) {
+		UpdateENC.seq = Frame.seq;
+		UpdateENC.timestamp = Frame.timestamp;
+		UpdateENC.count = 0;
+
+		for (int i = 0; i < BOARD_ENC_CHANNELS; ++i) {
+			if (ENCMask & (1 << i)) {
+				UpdateENC.channel[UpdateENC.count] = i;
+				UpdateENC.value[UpdateENC.count] = Frame.ENC[i];
+				++UpdateENC.count;
+			}
+		}
+
+		ENCChangeOutputPort.write(UpdateENC);
+	}
+}
+
+void S626_task::drainDIO(RTT::os::TimeService::nsecs Deadline) {
+	S626_drain_stats & Drain = DrainStats[S626_DRAIN_DIO];
+	int Masks[BOARD_DIO_BANKS], Values[BOARD_DIO_BANKS];
+	int Banks, Pending = 0;
+	unsigned int Count = 0;
+	bool Carried = false;
+
+	//a command held by the previous cycle is taken first
+	while (DrainHeld[S626_DRAIN_DIO]
+			|| DIOInputPortWrite.read(DataDIOWrite) == RTT::NewData) {
+		DrainHeld[S626_DRAIN_DIO] = false;
+
+		//carried only when another command is actually waiting
+		if (Count >= Drain.budget || (Count && Deadline
+				&& RTT::os::TimeService::Instance()->getNSecs() >= Deadline)) {
+			DrainHeld[S626_DRAIN_DIO] = true;
+			Carried = true;
+			break;
+		}
 
-	//check if there is new data on port for DIO write
+		++Count;
 
-	for (int k = 0; k < 15; ++k) {
-		if (DIOInputPortWrite.read(DataDIO) == RTT::NewData) {
-			Banks = DataDIO[0];
+		Banks = DataDIOWrite.empty() ? -1 : DataDIOWrite[0];
 
-			for (int i = 0, j = 0; i < 3; ++i) {
+		if (Banks < 0 || Banks > 0x07 || DataDIOWrite.size()
+				< 1 + 2 * (unsigned int) __builtin_popcount(Banks))
+			++Drain.dropped;
+		else {
+			for (int i = 0, j = 1; i < BOARD_DIO_BANKS; ++i) {
 				if (Banks & (1 << i)) {
-					Interface->setDIO(i, DataDIO[1 + j], DataDIO[1 + j + 1]);
+					int Mask = DataDIOWrite[j] & 0xFFFF;
+
+					if (!(Pending & (1 << i))) {
+						Masks[i] = 0;
+						Values[i] = 0;
+						Pending |= 1 << i;
+					} else if (Masks[i] & Mask)
+						++Drain.coalesced;
+
+					//later bits override earlier ones
+					Masks[i] |= Mask;
+					Values[i] = (Values[i] & ~Mask) | (DataDIOWrite[j + 1] & Mask);
 
 					j += 2;
 				}
 			}
-		} else
-			break;
+		}
 	}
 
-	for (int k = 0; k < 15; ++k) {
-		if (DACInputPort.read(DataDAC) == RTT::NewData) {
-			Channels = DataDAC[0];
+	for (int i = 0; i < BOARD_DIO_BANKS; ++i)
+		if (Pending & (1 << i))
+			Interface->setDIO(i, Masks[i], Values[i]);
+
+	adaptBudget(Drain, Count, Carried);
+}
+
+void S626_task::drainDAC(RTT::os::TimeService::nsecs Deadline) {
+	S626_drain_stats & Drain = DrainStats[S626_DRAIN_DAC];
+	int Values[BOARD_DAC_CHANNELS];
+	int Channels, Pending = 0;
+	unsigned int Count = 0;
+	bool Carried = false;
+
+	while (DrainHeld[S626_DRAIN_DAC] || DACInputPort.read(DataDAC) == RTT::NewData) {
+		DrainHeld[S626_DRAIN_DAC] = false;
 
-			for (unsigned int i = 0, j = 1; i < 4; ++i) {
+		if (Count >= Drain.budget || (Count && Deadline
+				&& RTT::os::TimeService::Instance()->getNSecs() >= Deadline)) {
+			DrainHeld[S626_DRAIN_DAC] = true;
+			Carried = true;
+			break;
+		}
+
+		++Count;
+
+		Channels = DataDAC.empty() ? -1 : DataDAC[0];
+
+		if (Channels < 0 || Channels > 0x0F || DataDAC.size()
+				< 1 + (unsigned int) __builtin_popcount(Channels))
+			++Drain.dropped;
+		else {
+			for (int i = 0, j = 1; i < BOARD_DAC_CHANNELS; ++i) {
 				if (Channels & (1 << i)) {
-					Interface->setDAC(i, DataDAC[j]);
+					if (Pending & (1 << i))
+						++Drain.coalesced;
+
+					Values[i] = DataDAC[j];
+					Pending |= 1 << i;
 					++j;
 				}
 			}
-		} else
-			break;
+		}
 	}
 
-	//read data from interface and redirect it to output ports
-	//dio
-	v.clear();
-	for(int i = 0; i < 3; ++i)
-	{
-		v.push_back(Interface->getDIO(i));
-	}
-	DIOOutputPortRead.write(v);
+	for (int i = 0; i < BOARD_DAC_CHANNELS; ++i)
+		if (Pending & (1 << i))
+			Interface->setDAC(i, Values[i]);
 
-	//adc
-	v.clear();
-	for(int i = 0; i < 16; ++i)
-	{
-		if(SelectedADCChannels & (1 << i))
-		{
-			v.push_back(Interface->getADC(i));
-		}
-	}
-	ADCOutputPort.write(v);
+	adaptBudget(Drain, Count, Carried);
+}
 
-	//enc
-	v.clear();
-	for(int i = 0; i < 6; ++i)
-	{
-		if(SelectedENCChannels & (1 << i))
-		{
-			v.push_back(Interface->getENC(i));
-		}
+void S626_task::adaptBudget(S626_drain_stats & Drain, unsigned int Count,
+		bool Carried) {
+	unsigned int Max = DrainBudgetMax;
+
+	if (Max < S626_TASK_DRAIN_BUDGET_MIN)
+		Max = S626_TASK_DRAIN_BUDGET_MIN;
+
+	Drain.drained += Count;
+	if (Count > Drain.peak)
+		Drain.peak = Count;
+
+	if (Carried) {
+		++Drain.carriedCycles;
+
+		Drain.budget *= 2;
+		if (Drain.budget > Max)
+			Drain.budget = Max;
+	} else if (Count < Drain.budget / 4) {
+		Drain.budget /= 2;
+		if (Drain.budget < S626_TASK_DRAIN_BUDGET_MIN)
+			Drain.budget = S626_TASK_DRAIN_BUDGET_MIN;
 	}
-	ENCOutputPort.write(v);
+}
+
+void S626_task::prepareSamples(void) {
+	int Count;
+
+	DataDIORead.resize(BOARD_DIO_BANKS);
+	DIOOutputPortRead.setDataSample(DataDIORead);
 
+	Count = 0;
+	for (int i = 0; i < BOARD_ADC_CHANNELS; ++i)
+		if (SelectedADCChannels & (1 << i))
+			ADCIndex[Count++] = i;
+	DataADC.resize(Count);
+	ADCOutputPort.setDataSample(DataADC);
+
+	Count = 0;
+	for (int i = 0; i < BOARD_ENC_CHANNELS; ++i)
+		if (SelectedENCChannels & (1 << i))
+			ENCIndex[Count++] = i;
+	DataENC.resize(Count);
+	ENCOutputPort.setDataSample(DataENC);
+
+	ChangesReset = true;
 }
 
 void S626_task::stopHook() {
 	std::cout << "S626_task executes stopping !" << std::endl;
 
-	Interface->stop();
+	Interface->setTrigger(NULL);
+
+	if (Engine) {
+		Acquisition_engine::detach(Engine, Interface);
+		Engine = NULL;
+	} else
+		Interface->stop();
+
+	//remaining records are written when the thread stops
+	Log->stop();
 }
 
 void S626_task::cleanupHook() {
 	std::cout << "S626_task cleaning up !" << std::endl;
 
-	Interface->stopDriver();
+	//objects live as long as the component, operations may use
+	//them in any state and a following configure reopens the board
+	Driver->shutdown();
 
-	delete Interface;
+	stopRecording();
 }
 
 void S626_task::setActivePublishing(int state) {
@@ -251,14 +893,16 @@ void S626_task::setInitialDIO( std::vector<double> InitialDIO)
 
 void S626_task::setInitialADC( int InitialADC)
 {
-	SelectedADCChannels = InitialADC;
+	SelectedADCChannels = InitialADC & 0xFFFF;
 	Interface->setInitialADC(InitialADC);
+	prepareSamples();
 }
 
 void S626_task::setInitialENC( int InitialENC)
 {
-	SelectedENCChannels = InitialENC;
+	SelectedENCChannels = InitialENC & 0x3F;
 	Interface->setInitialENC(InitialENC);
+	prepareSamples();
 }
 
 int S626_task::readDIO(int bank) {
@@ -310,7 +954,10 @@ void S626_task::writeDAC(int channel, int value) {
 }
 
 int S626_task::prepareAllENC(void) {
-	return Interface->prepareENC();
+	//configured by the driver thread, now or when the board is opened
+	Driver->requestENC();
+
+	return 0;
 }
 
 int S626_task::readENC(int enc) {
@@ -322,24 +969,436 @@ int S626_task::readENC(int enc) {
 	}
 }
 
+std::vector<int> S626_task::readAllADC(int Mask) {
+	std::vector<int> Values;
+	S626_frame Frame;
+
+	Interface->getFrame(Frame);
+
+	for (int i = 0; i < BOARD_ADC_CHANNELS; ++i)
+		if (Mask & (1 << i))
+			Values.push_back(Frame.ADC[i]);
+
+	return Values;
+}
+
+std::vector<int> S626_task::readAllENC(int Mask) {
+	std::vector<int> Values;
+	S626_frame Frame;
+
+	Interface->getFrame(Frame);
+
+	for (int i = 0; i < BOARD_ENC_CHANNELS; ++i)
+		if (Mask & (1 << i))
+			Values.push_back(Frame.ENC[i]);
+
+	return Values;
+}
+
+void S626_task::writeDACs(int Mask, std::vector<int> Values) {
+	unsigned int Next = 0;
+
+	for (int i = 0; i < BOARD_DAC_CHANNELS; ++i) {
+		if (!(Mask & (1 << i)))
+			continue;
+
+		if (Next >= Values.size()) {
+			std::cout << "Missing values, expected one for every selected channel\n";
+			return;
+		}
+
+		int Value = Values[Next++];
+
+		if (Value < 0)
+			Value = 0;
+		else if (Value > 0x3FFF)
+			Value = 0x3FFF;
+
+		//staged channels are flushed together in the next cycle
+		Interface->setDAC(i, Value);
+	}
+}
+
+void S626_task::writeDIOBanks(std::vector<int> Masks, std::vector<int> Values) {
+	if (Masks.size() > BOARD_DIO_BANKS || Values.size() < Masks.size()) {
+		std::cout << "Bad number of banks, please enter at most 3 masks and values\n";
+		return;
+	}
+
+	for (unsigned int i = 0; i < Masks.size(); ++i)
+		Interface->setDIO(i, Masks[i], Values[i]);
+}
+
+int S626_task::loadWaveform(int Channel, std::vector<int> Samples, int Mode,
+		int Divider) {
+	if (Interface->getWaveform()->load(Channel, Samples, Mode, Divider) < 0) {
+		std::cout << "Bad waveform, please enter channel 0-3, 1-"
+				<< WAVEFORM_MAX_SAMPLES << " samples, mode 0-1 and divider >= 1\n";
+		return -1;
+	}
+
+	return 0;
+}
+
+void S626_task::stopWaveform(int Channel) {
+	Interface->getWaveform()->stop(Channel);
+}
+
+bool S626_task::isWaveformPlaying(int Channel) {
+	return Interface->getWaveform()->isPlaying(Channel);
+}
+
+unsigned int S626_task::getWaveformSegments(int Channel) {
+	return Interface->getWaveform()->getCompleted(Channel);
+}
+
+void S626_task::setADCMode(int Mode, double Period) {
+	if (Mode == INTERFACE_ADC_MODE_SYNC || Mode == INTERFACE_ADC_MODE_SCAN)
+		Interface->setADCMode(Mode, Period);
+	else
+		std::cout << "Bad ADC mode, please enter value 0-1\n";
+}
+
+S626_cycle_stats S626_task::getCycleStats(void) {
+	S626_cycle_stats CycleStats;
+
+	Interface->getCycleStats(CycleStats);
+
+	return CycleStats;
+}
+
+double S626_task::getCyclePercentile(int Stage, double Percentile) {
+	if (Stage < 0 || Stage >= INTERFACE_STAGES) {
+		std::cout << "Bad stage, please enter value 0-3\n";
+		return -1.0;
+	}
+
+	return (double) Interface->getCyclePercentile(Stage, Percentile);
+}
+
+void S626_task::resetCycleStats(void) {
+	Interface->resetCycleStats();
+}
+
+void S626_task::setRateDivider(int Peripheral, int Mask, int Divider) {
+	if (Peripheral != BOARD_PERIPHERAL_ADC && Peripheral != BOARD_PERIPHERAL_ENC
+			&& Peripheral != BOARD_PERIPHERAL_DIO) {
+		std::cout << "Bad peripheral, please enter 0, 2 or 3\n";
+		return;
+	}
+
+	if (Divider < 1) {
+		std::cout << "Bad divider, has to be at least 1\n";
+		return;
+	}
+
+	Interface->setRateDivider(Peripheral, Mask, Divider);
+}
+
+bool S626_task::setInterfacePeriod(double Period) {
+	double Rate = Interface->getAchievableRate();
+
+	if (engineOwnsTiming())
+		return false;
+
+	if (Period <= 0.0) {
+		std::cout << "Bad period, has to be positive\n";
+		return false;
+	}
+
+	if (Rate > 0.0 && Period < 1.0 / Rate) {
+		std::cout << "Period " << Period << " s is too short, measured step allows "
+				<< Rate << " Hz\n";
+		return false;
+	}
+
+	if (!Interface->setCyclePeriod(Period))
+		return false;
+
+	InterfacePeriod = Period;
+
+	return true;
+}
+
+bool S626_task::setInterfacePriority(int Scheduler, int Priority) {
+	if (engineOwnsTiming())
+		return false;
+
+	if (!Interface->setScheduler(Scheduler)) {
+		std::cout << "Can not set scheduler " << Scheduler << "\n";
+		return false;
+	}
+
+	if (!Interface->setPriority(Priority)) {
+		std::cout << "Can not set priority " << Priority << "\n";
+		return false;
+	}
+
+	InterfaceScheduler = Scheduler;
+	InterfacePriority = Interface->getPriority();
+
+	return true;
+}
+
+bool S626_task::setInterfaceCpuAffinity(unsigned int CpuAffinity) {
+	if (engineOwnsTiming())
+		return false;
+
+	Interface->setCpuAffinity(CpuAffinity);
+
+	InterfaceCpuAffinity = Interface->getCpuAffinity();
+
+	return true;
+}
+
+bool S626_task::engineOwnsTiming(void) {
+	if (Engine == NULL)
+		return false;
+
+	RTT::log(RTT::Logger::Error) << "Interface timing of " << getName()
+			<< " is owned by acquisition engine " << AcquisitionEngine
+			<< RTT::endlog();
+
+	return true;
+}
+
+double S626_task::getAchievableRate(void) {
+	return Interface->getAchievableRate();
+}
+
+bool S626_task::startRecording(std::string File, double Size) {
+	if (Size <= 0.0)
+		return false;
+
+	if (Recorder->open(File, (unsigned long long) (Size * 1024.0 * 1024.0)) < 0) {
+		std::cout << "Recording " << File << " could not be started\n";
+		return false;
+	}
+
+	Recorder->start();
+
+	return true;
+}
+
+void S626_task::stopRecording(void) {
+	Recorder->stop();
+
+	Recorder->close();
+}
+
+bool S626_task::startSharedMemory(std::string Name) {
+	if (Name.empty())
+		Name = "/" + getName();
+
+	if (!SharedMemory->open(Name)) {
+		std::cout << "Shared memory " << Name << " could not be created\n";
+		return false;
+	}
+
+	return true;
+}
+
+void S626_task::stopSharedMemory(void) {
+	SharedMemory->close();
+}
+
+unsigned int S626_task::getRecordedFrames(void) {
+	return (unsigned int) Recorder->getFrames();
+}
+
+unsigned int S626_task::getDroppedFrames(void) {
+	return (unsigned int) Recorder->getDropped();
+}
+
+bool S626_task::selectBackend(std::string Backend) {
+	Board_backend * NewBackend = createBoardBackend(Backend);
+
+	if (NewBackend == NULL) {
+		std::cout << "Unknown backend " << Backend << "\n";
+		return false;
+	}
+
+	//replaced by the driver thread, the new backend is opened by
+	//a following prepareDriver
+	Driver->requestBackend(NewBackend);
+
+	return true;
+}
+
+void S626_task::setDeadbandADC(int Mask, int Threshold) {
+	for (int i = 0; i < BOARD_ADC_CHANNELS; ++i)
+		if (Mask & (1 << i))
+			DeadbandADC[i] = Threshold < 0 ? 0 : Threshold;
+
+	ChangesReset = true;
+}
+
+void S626_task::setDeadbandENC(int Mask, int Threshold) {
+	for (int i = 0; i < BOARD_ENC_CHANNELS; ++i)
+		if (Mask & (1 << i))
+			DeadbandENC[i] = Threshold < 0 ? 0 : Threshold;
+
+	ChangesReset = true;
+}
+
+std::vector<int> S626_task::getRisingEdges(int Bank) {
+	unsigned int Rising[16], Falling[16];
+	std::vector<int> Result;
+
+	if (Bank < 0 || Bank >= BOARD_DIO_BANKS) {
+		std::cout << "Bad bank number, please enter value 0-2\n";
+		return Result;
+	}
+
+	Interface->getEdgeCounts(Bank, Rising, Falling);
+	Result.assign(Rising, Rising + 16);
+
+	return Result;
+}
+
+std::vector<int> S626_task::getFallingEdges(int Bank) {
+	unsigned int Rising[16], Falling[16];
+	std::vector<int> Result;
+
+	if (Bank < 0 || Bank >= BOARD_DIO_BANKS) {
+		std::cout << "Bad bank number, please enter value 0-2\n";
+		return Result;
+	}
+
+	Interface->getEdgeCounts(Bank, Rising, Falling);
+	Result.assign(Falling, Falling + 16);
+
+	return Result;
+}
+
+void S626_task::resetEdgeCounts(void) {
+	Interface->resetEdgeCounts();
+}
+
+unsigned int S626_task::getLostEdges(void) {
+	return Interface->getEdgeOverflow();
+}
+
+S626_drain_stats S626_task::getDrainStats(int Port) {
+	S626_drain_stats Result;
+
+	if (Port >= 0 && Port < S626_DRAIN_PORTS)
+		return DrainStats[Port];
+
+	std::cout << "Bad port number, please enter value 0-1\n";
+	memset(&Result, 0, sizeof(Result));
+
+	return Result;
+}
+
+void S626_task::resetDrainStats(void) {
+	for (int i = 0; i < S626_DRAIN_PORTS; ++i) {
+		unsigned int Budget = DrainStats[i].budget;
+
+		memset(&DrainStats[i], 0, sizeof(DrainStats[i]));
+		DrainStats[i].budget = Budget;
+	}
+}
+
+void S626_task::setSimulatedLatency(int Latency) {
+	Sim_backend * Sim = dynamic_cast<Sim_backend *>(Interface->getBackend());
+
+	if (Sim)
+		Sim->setLatency(Latency);
+	else
+		std::cout << "Simulated latency requires sim backend\n";
+}
+
+void S626_task::injectSimulatedError(int Peripheral, int Channel, int Error,
+		int Count) {
+	Sim_backend * Sim = dynamic_cast<Sim_backend *>(Interface->getBackend());
+
+	if (Sim) {
+		if (!Sim->injectError(Peripheral, Channel, Error, Count))
+			std::cout << "Error injection requires a valid peripheral"
+					" and a negative error code\n";
+	} else
+		std::cout << "Error injection requires sim backend\n";
+}
+
+void S626_task::setReplayMode(int Mode, double Speed) {
+	Replay_backend * Replay =
+			dynamic_cast<Replay_backend *>(Interface->getBackend());
+
+	if (Replay) {
+		Replay->setMode(Mode, Speed);
+		if (Mode == REPLAY_MODE_AFAP && !TriggerOnFrame)
+			std::cout << "As fast as possible replay without TriggerOnFrame"
+					" overwrites frames before periodic components read them\n";
+	} else
+		std::cout << "Replay mode requires replay backend\n";
+}
+
+void S626_task::rewindReplay(void) {
+	Replay_backend * Replay =
+			dynamic_cast<Replay_backend *>(Interface->getBackend());
+
+	if (Replay)
+		Replay->rewind();
+	else
+		std::cout << "Rewind requires replay backend\n";
+}
+
+bool S626_task::isReplayFinished(void) {
+	Replay_backend * Replay =
+			dynamic_cast<Replay_backend *>(Interface->getBackend());
+
+	return Replay ? Replay->isFinished() : false;
+}
+
+int S626_task::saveReplayCapture(std::string File) {
+	Replay_backend * Replay =
+			dynamic_cast<Replay_backend *>(Interface->getBackend());
+
+	if (Replay == NULL) {
+		std::cout << "Capture requires replay backend\n";
+		return -1;
+	}
+
+	int Count = Replay->saveCapture(File);
+
+	if (Replay->getCaptureOverflow() > 0)
+		std::cout << "Replay capture overflowed, "
+				<< Replay->getCaptureOverflow() << " writes were not saved\n";
+
+	return Count;
+}
+
 int S626_task::getLastError(void) {
-	int lastError;
-	lastError = err;
-	err = 0;
+	return Log->getLastError();
+}
+
+unsigned int S626_task::getErrorCount(int Peripheral, int Channel) {
+	return Log->getErrors(Peripheral, Channel);
+}
+
+void S626_task::resetErrorCounts(void) {
+	Log->resetErrors();
+}
+
+void S626_task::closeDriver(void) {
+	Driver->requestClose();
+}
+
+int S626_task::getDriverState(void) {
+	return Driver->getState();
+}
 
-	return lastError;
+unsigned int S626_task::getDriverRecoveries(void) {
+	return Driver->getRecoveries();
 }
 
 /*
- * Using this macro, only one component may live
- * in one library *and* you may *not* link this library
- * with another component library. Use
- * ORO_CREATE_COMPONENT_TYPE()
- * ORO_LIST_COMPONENT_TYPE(S626_task)
- * In case you want to link with another library that
- * already contains components.
+ * The library contains S626_task and S626_group,
+ * S626_group is listed in its own file.
  *
  * If you have put your component class
  * in a namespace, don't forget to add it here too:
  */
-ORO_CREATE_COMPONENT(S626_task)
+ORO_CREATE_COMPONENT_LIBRARY()
+ORO_LIST_COMPONENT_TYPE(S626_task)
@@ -32,12 +32,22 @@
 
 #include <vector>
 
-#include "S626API.h"
-
 #include "Interface-thread.hpp"
+#include "Acquisition-engine.hpp"
+#include "Driver-manager.hpp"
 
 #include <rtt/os/Mutex.hpp>
 
+/**
+ * Bounds of the number of commands read from
+ * an input port in one cycle
+ */
+#define S626_TASK_DRAIN_BUDGET_MIN 15
+#define S626_TASK_DRAIN_BUDGET_MAX 256
+
+#define S626_TASK_PUBLISH_ALL 0
+#define S626_TASK_PUBLISH_CHANGES 1
+
 /**
  * \brief S626_task
  *
@@ -49,6 +59,7 @@ class S626_task : public RTT::TaskContext{
   public:
 
     S626_task(std::string const& name);
+    ~S626_task();
 
     bool configureHook();
     bool startHook();
@@ -130,13 +141,98 @@ class S626_task : public RTT::TaskContext{
      */
     int readENC( int enc);
 
+    /**
+     * \brief readAllADC
+     *
+     * Reads the selected analog channels from the same frame.
+     *
+     * \param[in]	Mask		Channel selector, bit 0 corresponds to channel 0
+     *
+     * \return		Values of the selected channels in ascending order
+     */
+    std::vector<int> readAllADC( int Mask);
+
+    /**
+     * \brief readAllENC
+     *
+     * Reads the selected encoders from the same frame.
+     *
+     * \param[in]	Mask		Encoder selector, bit 0 corresponds to encoder 0
+     *
+     * \return		Values of the selected encoders in ascending order
+     */
+    std::vector<int> readAllENC( int Mask);
+
+    /**
+     * \brief writeDACs
+     *
+     * Stages the selected DAC channels with a single call,
+     * they are written by the next cycle of the interface thread.
+     *
+     * \param[in]	Mask		Channel selector, bit 0 corresponds to channel 0
+     * \param[in]	Values	Values of the selected channels in ascending order,
+     * 										from 0 to 2^14 - 1
+     */
+    void writeDACs( int Mask, std::vector<int> Values);
+
+    /**
+     * \brief writeDIOBanks
+     *
+     * Stages outputs of the DIO banks with a single call,
+     * they are written by the next cycle of the interface thread.
+     *
+     * \param[in]	Masks		Bits to be written of banks 0-2,
+     * 										banks with empty mask are not written
+     * \param[in]	Values	Value of each bank
+     */
+    void writeDIOBanks( std::vector<int> Masks, std::vector<int> Values);
+
+    /**
+     * \brief loadWaveform
+     *
+     * Uploads a waveform played on the DAC channel by the interface
+     * thread, one sample every Divider periods of the thread.
+     * Waveform loaded while another one is played starts right after
+     * the last sample of the played one. Samples override values
+     * written by writeDAC while the waveform is played.
+     *
+     * \param[in]	Channel		DAC channel 0-3
+     * \param[in]	Samples		Values from 0 to 2^14 - 1, at most 4096
+     * \param[in]	Mode			0 - played once, 1 - played in a loop
+     * \param[in]	Divider		Number of periods of the interface thread
+     * 											each sample is held
+     *
+     * \return		0 on success, -1 on bad arguments
+     */
+    int loadWaveform( int Channel, std::vector<int> Samples, int Mode,
+    		int Divider);
+
+    /**
+     * \brief stopWaveform
+     *
+     * Stops the waveform and drops the queued one,
+     * the last sample stays on the output.
+     */
+    void stopWaveform( int Channel);
+
+    bool isWaveformPlaying( int Channel);
+
+    /**
+     * \brief getWaveformSegments
+     *
+     * \return		Number of waveforms of the channel played to the end,
+     * 						each pass of a looped one counts
+     */
+    unsigned int getWaveformSegments( int Channel);
+
     /**
      * \brief	prepareAllENC
      *
-     * Prepares all the encoders for work
+     * Requests all the encoders to be prepared for work by the driver
+     * thread, right away when the board is open. Encoders are prepared
+     * again every time the board is opened or recovered.
      *
-     * \return			0			When everything was performed without error
-     * 						!=0			Otherwise
+     * \return			0			Request was accepted
      */
     int prepareAllENC( void);
 
@@ -146,25 +242,61 @@ class S626_task : public RTT::TaskContext{
      * Return standard error code. For more informations please look
      * into standard linux kernel errors.
      *
-     * \return error code
+     * \return error code of the last failure, 0 when there
+     * 				was none since the previous call
      */
     int getLastError( void);
 
+    /**
+     * \brief getErrorCount
+     *
+     * \param[in]	Peripheral	0 - ADC, 1 - DAC, 2 - ENC, 3 - DIO,
+     * 												4 - operations on the whole board
+     * \param[in]	Channel			Channel or bank, -1 for all of them
+     *
+     * \return		Number of failures since the last reset
+     */
+    unsigned int getErrorCount( int Peripheral, int Channel);
+
+    void resetErrorCounts( void);
+
     /**
      * \brief prepareDriver
      *
-     * Prepares driver for work.
+     * Requests the driver to be prepared for work. The board is opened
+     * by a helper thread, poll \link getDriverState getDriverState \endlink
+     * to know when it is ready.
      *
      * \param[in]	Device		Name of analogy device ex. analogy0, analogy1, ...
      * \param[in] Bus				Bus number on which s626 is physically available
      * \param[in] Slot			Slot number on which s626 is physically available
      *
-     * \return		0					Component and card is ready to use
-     * 					!=0					Last error code. For more information look at dmesg output and
-     * 											getLastError to obtain last error code.
+     * \return		0					Request was accepted
      */
     int prepareDriver( std::string Device, int Bus, int Slot);
 
+    /**
+     * \brief closeDriver
+     *
+     * Requests the board to be closed by the helper thread.
+     */
+    void closeDriver( void);
+
+    /**
+     * \brief getDriverState
+     *
+     * \return		0 - closed, 1 - opening, 2 - open, 3 - closing,
+     * 						4 - failed, 5 - recovering after repeated read failures
+     */
+    int getDriverState( void);
+
+    /**
+     * \brief getDriverRecoveries
+     *
+     * \return		Number of times the board was re-attached by the watchdog
+     */
+    unsigned int getDriverRecoveries( void);
+
     /**
      * \brief setActivePublishing
      *
@@ -222,12 +354,318 @@ class S626_task : public RTT::TaskContext{
      */
     void setInitialENC( int InitialENC);
 
-  private:
+    /**
+     * \brief setADCMode
+     *
+     * Selects how ADC channels are acquired.
+     *
+     * \param[in]	Mode			0 - every channel is converted on demand
+     * 											in each cycle of the interface thread,
+     * 											1 - the board scans the channels with its own
+     * 											timer into the Analogy buffer and each cycle
+     * 											takes the latest complete scan from it
+     * \param[in]	Period		Time between hardware scans in seconds,
+     * 											used only in mode 1
+     */
+    void setADCMode( int Mode, double Period);
+
+    /**
+     * \brief getCycleStats
+     *
+     * Returns timing of the interface thread: wake-up latency,
+     * duration of the frame read, ADC scan and whole step,
+     * each with min, max, mean and percentiles, and the number
+     * of missed deadlines.
+     *
+     * \return		Timing summary, all times in nanoseconds
+     */
+    S626_cycle_stats getCycleStats( void);
+
+    /**
+     * \brief getDrainStats
+     *
+     * Returns accounting of commands read from an input port.
+     *
+     * \param[in]	Port		0 - DIOInputPortWrite, 1 - DACInputPort
+     */
+    S626_drain_stats getDrainStats( int Port);
+
+    /**
+     * \brief setDeadbandADC
+     *
+     * In change publishing mode a channel is published when it differs
+     * from its last published value by more than the threshold.
+     *
+     * \param[in]	Mask			ADC channel selector
+     * \param[in]	Threshold	Deadband in raw units, 0 publishes every change
+     */
+    void setDeadbandADC( int Mask, int Threshold);
+
+    /**
+     * \brief setDeadbandENC
+     *
+     * Same as \link setDeadbandADC setDeadbandADC \endlink for encoders.
+     */
+    void setDeadbandENC( int Mask, int Threshold);
+
+    /**
+     * \brief getRisingEdges
+     *
+     * \param[in]	Bank		Bank number 0-2
+     *
+     * \return		Number of rising edges of each of 16 bits
+     */
+    std::vector<int> getRisingEdges( int Bank);
+
+    /**
+     * \brief getFallingEdges
+     *
+     * \param[in]	Bank		Bank number 0-2
+     *
+     * \return		Number of falling edges of each of 16 bits
+     */
+    std::vector<int> getFallingEdges( int Bank);
+
+    /**
+     * \brief resetEdgeCounts
+     *
+     * Clears edge counters of all the banks.
+     */
+    void resetEdgeCounts( void);
+
+    /**
+     * \brief getLostEdges
+     *
+     * \return		Number of edge events not published because
+     * 						the component did not keep up with the changes
+     */
+    unsigned int getLostEdges( void);
+
+    /**
+     * \brief resetDrainStats
+     *
+     * Clears counters of both input ports, budgets are kept.
+     */
+    void resetDrainStats( void);
+
+    /**
+     * \brief getCyclePercentile
+     *
+     * \param[in]	Stage				0 - wake-up latency, 1 - frame read,
+     * 												2 - ADC scan, 3 - whole step
+     * \param[in]	Percentile	Value from 0 to 100
+     *
+     * \return		Percentile of the stage duration in nanoseconds
+     */
+    double getCyclePercentile( int Stage, double Percentile);
+
+    /**
+     * \brief resetCycleStats
+     *
+     * Clears timing histograms of the interface thread.
+     */
+    void resetCycleStats( void);
+
+    /**
+     * \brief setRateDivider
+     *
+     * Reads selected channels only every Divider-th cycle of the
+     * interface thread. Slow channels are spread over the cycles.
+     * Sequence number of the frame which read each value is
+     * available in FrameOutputPort.
+     *
+     * Example: encoders every cycle, ADC 0-3 every 2nd cycle
+     * and DIO every 10th cycle
+     * setRateDivider(0, 0x000F, 2);
+     * setRateDivider(3, 0x7, 10);
+     *
+     * \param[in]	Peripheral	0 - ADC, 2 - ENC, 3 - DIO
+     * \param[in]	Mask				Channels or banks affected
+     * \param[in]	Divider			1 reads in every cycle
+     */
+    void setRateDivider( int Peripheral, int Mask, int Divider);
+
+    /**
+     * \brief setInterfacePeriod
+     *
+     * Changes the period of the interface thread, also while it runs.
+     * The period is rejected when it is shorter than the 99th percentile
+     * of the measured step duration. While the board is serviced by
+     * an acquisition engine the engine owns the timing and nothing
+     * is changed.
+     *
+     * \param[in]	Period		Period in seconds
+     *
+     * \return		true			When the period was applied
+     * 						false			When it was rejected or the board is
+     * 											attached to an engine
+     */
+    bool setInterfacePeriod( double Period);
+
+    /**
+     * \brief setInterfacePriority
+     *
+     * Changes scheduler and priority of the interface thread.
+     * Rejected while the board is serviced by an acquisition engine.
+     *
+     * \param[in]	Scheduler		ORO_SCHED_RT or ORO_SCHED_OTHER
+     * \param[in]	Priority		Priority of the thread
+     *
+     * \return		true				When both were applied
+     */
+    bool setInterfacePriority( int Scheduler, int Priority);
+
+    /**
+     * \brief setInterfaceCpuAffinity
+     *
+     * Changes CPUs the interface thread may run on.
+     * Rejected while the board is serviced by an acquisition engine.
+     *
+     * \param[in]	CpuAffinity		Mask of CPUs, bit 0 corresponds to CPU 0
+     *
+     * \return		true					When the affinity was applied
+     */
+    bool setInterfaceCpuAffinity( unsigned int CpuAffinity);
+
+    /**
+     * \brief getAchievableRate
+     *
+     * \return		Maximal rate of the interface thread in Hz estimated from
+     * 						the 99th percentile of the measured step duration,
+     * 						0 when nothing was measured yet
+     */
+    double getAchievableRate( void);
+
+    /**
+     * \brief startRecording
+     *
+     * Starts recording of every frame acquired by the interface
+     * thread. Use s626_export to convert the file.
+     *
+     * \param[in]	File		Path of the recording
+     * \param[in]	Size		Size of the preallocated file in MB,
+     * 										frames which do not fit are dropped
+     *
+     * \return		true when the recording was started
+     */
+    bool startRecording( std::string File, double Size);
+
+    /**
+     * \brief stopRecording
+     *
+     * Writes remaining frames and closes the recording.
+     */
+    void stopRecording( void);
+
+    /**
+     * \brief startSharedMemory
+     *
+     * Publishes every frame acquired by the interface thread into
+     * a POSIX shared memory segment, read by other processes
+     * with Frame_shm_reader of Frame-shm.hpp.
+     *
+     * \param[in]	Name		Name of the segment, empty for /<component name>
+     *
+     * \return		true when the segment was created
+     */
+    bool startSharedMemory( std::string Name);
+
+    /**
+     * \brief stopSharedMemory
+     *
+     * Removes the segment.
+     */
+    void stopSharedMemory( void);
+
+    /**
+     * \brief getRecordedFrames
+     *
+     * \return		Number of frames in the current or last recording
+     */
+    unsigned int getRecordedFrames( void);
 
     /**
-     * Holds lat error code
+     * \brief getDroppedFrames
+     *
+     * \return		Number of frames missing in the current or last recording
      */
-    int err;
+    unsigned int getDroppedFrames( void);
+
+    /**
+     * \brief selectBackend
+     *
+     * Selects the board backend. Has to be called before
+     * \link prepareDriver prepareDriver \endlink. The board is closed
+     * and the backend replaced by the driver thread.
+     *
+     * \param[in]	Backend		"analogy" for the real board accessed through
+     * 											Xenomai Analogy driver, "sim" for the simulated board,
+     * 											"replay" for a recorded session, in which case
+     * 											Device holds the path of the recording
+     *
+     * \return		true			When the backend was requested, getDriverState
+     * 											reports failed when the driver could not be stopped
+     * 						false			When the backend is not known
+     */
+    bool selectBackend( std::string Backend);
+
+    /**
+     * \brief setSimulatedLatency
+     *
+     * Sets latency of every call to the simulated board.
+     * Works only with "sim" backend.
+     *
+     * \param[in]	Latency		Latency in nanoseconds
+     */
+    void setSimulatedLatency( int Latency);
+
+    /**
+     * \brief injectSimulatedError
+     *
+     * Makes the simulated board fail next Count calls.
+     * Works only with "sim" backend.
+     *
+     * \param[in]	Peripheral	0 - ADC, 1 - DAC, 2 - ENC, 3 - DIO
+     * \param[in]	Channel			Channel or bank, -1 for all of them
+     * \param[in]	Error				Negative error code to be returned
+     * \param[in]	Count				Number of failing calls
+     */
+    void injectSimulatedError( int Peripheral, int Channel, int Error, int Count);
+
+    /**
+     * \brief setReplayMode
+     *
+     * Works only with "replay" backend.
+     *
+     * \param[in]	Mode		0 - real time, 1 - scaled, 2 - as fast as possible,
+     * 										which replays frames as fast as the interface
+     * 										thread and the triggered component take them;
+     * 										needs TriggerOnFrame, otherwise periodic
+     * 										components miss intermediate frames
+     * \param[in]	Speed		Speed factor of scaled mode
+     */
+    void setReplayMode( int Mode, double Speed);
+
+    /**
+     * \brief rewindReplay
+     *
+     * Starts the replayed session from the beginning
+     * and clears captured writes.
+     */
+    void rewindReplay( void);
+
+    bool isReplayFinished( void);
+
+    /**
+     * \brief saveReplayCapture
+     *
+     * Saves DAC and DIO writes issued during replay as CSV.
+     *
+     * \return		Number of saved writes or -1
+     */
+    int saveReplayCapture( std::string File);
+
+  private:
 
     std::string Device;
     int Bus;
@@ -236,9 +674,220 @@ class S626_task : public RTT::TaskContext{
 
     Interface_thread * Interface;
 
+    /**
+     * Scheduling of the interface thread
+     */
+    int InterfaceScheduler;
+    int InterfacePriority;
+    double InterfacePeriod;
+    unsigned int InterfaceCpuAffinity;
+
+    /**
+     * Name of the acquisition engine shared with other
+     * boards, empty when the board runs its own thread
+     */
+    std::string AcquisitionEngine;
+
+    /**
+     * Engine servicing the board while running
+     */
+    Acquisition_engine * Engine;
+
+    /**
+     * Writer of recordings, attached to the interface thread
+     */
+    Frame_recorder * Recorder;
+
+    /**
+     * Shared memory export, attached to the interface thread
+     */
+    Frame_shm_writer * SharedMemory;
+
+    /**
+     * Counters and log of failures, attached to the interface thread
+     */
+    Diag_log * Log;
+
+    /**
+     * Opens, closes and recovers the board off the acquisition thread
+     */
+    Driver_manager * Driver;
+
+    /**
+     * Number of consecutive failed cycles after which the board
+     * is re-attached, 0 disables the watchdog
+     */
+    int WatchdogFailures;
+
     int SelectedADCChannels;
     int SelectedENCChannels;
 
+    /**
+     * Selected channels in the order of published
+     * samples, compiled by prepareSamples
+     */
+    int ADCIndex[BOARD_ADC_CHANNELS];
+    int ENCIndex[BOARD_ENC_CHANNELS];
+
+    /**
+     * Samples preallocated for the maximal number of
+     * channels, so updateHook does not allocate
+     */
+    std::vector<int> DataDIORead;
+    std::vector<int> DataADC;
+    std::vector<int> DataENC;
+    std::vector<int> DataDIOWrite;
+    std::vector<int> DataDAC;
+
+    S626_frame Frame;
+
+    S626_dio_edge Edge;
+
+    /**
+     * Period of publishing on StatsOutputPort in seconds,
+     * 0 disables publishing
+     */
+    double StatsPeriod;
+
+    /**
+     * Time of the last publishing on StatsOutputPort
+     */
+    RTT::os::TimeService::nsecs StatsPublished;
+
+    S626_cycle_stats Stats;
+
+    /**
+     * When true the interface thread triggers the component
+     * after every frame, the component has to run in non
+     * periodic activity, otherwise it refuses to start.
+     * Ports are written only when a new frame was acquired.
+     */
+    bool TriggerOnFrame;
+
+    /**
+     * Sequence number of the last published frame
+     */
+    unsigned int PublishedSeq;
+
+    /**
+     * Age of the published data in seconds
+     */
+    double DataAge;
+
+    /**
+     * Upper bound of the adaptive number of commands
+     * read from an input port in one cycle
+     */
+    unsigned int DrainBudgetMax;
+
+    /**
+     * Time in seconds for reading input ports in one cycle,
+     * 0 uses half of the period of a periodic activity
+     */
+    double DrainTime;
+
+    S626_drain_stats DrainStats[S626_DRAIN_PORTS];
+
+    /**
+     * A command was read past the budget or the deadline and is
+     * kept in DataDIOWrite or DataDAC for the next cycle
+     */
+    bool DrainHeld[S626_DRAIN_PORTS];
+
+    /**
+     * S626_TASK_PUBLISH_ALL publishes all the selected channels on
+     * ADCOutputPort and ENCOutputPort, S626_TASK_PUBLISH_CHANGES only
+     * changed channels on ADCChangeOutputPort and ENCChangeOutputPort
+     */
+    int PublishMode;
+
+    /**
+     * Longest time in seconds a selected channel is not published
+     * in change publishing mode, 0 disables the heartbeat
+     */
+    double Heartbeat;
+
+    int DeadbandADC[BOARD_ADC_CHANNELS];
+    int DeadbandENC[BOARD_ENC_CHANNELS];
+
+    /**
+     * Last published values and their publishing times
+     */
+    int PublishedADC[BOARD_ADC_CHANNELS];
+    int PublishedENC[BOARD_ENC_CHANNELS];
+    RTT::os::TimeService::nsecs SentADC[BOARD_ADC_CHANNELS];
+    RTT::os::TimeService::nsecs SentENC[BOARD_ENC_CHANNELS];
+
+    /**
+     * Publishes all selected channels in the next change update
+     */
+    bool ChangesReset;
+
+    S626_channel_update UpdateADC;
+    S626_channel_update UpdateENC;
+
+    /**
+     * \brief changed
+     *
+     * Deadband and heartbeat pass over all the channels of a
+     * peripheral, updates published values of changed channels.
+     *
+     * \return		Mask of selected channels to be published
+     */
+    static int changed( const int * Values, int * Published, const int * Deadband,
+        RTT::os::TimeService::nsecs * Sent, int Count, int Selected,
+        RTT::os::TimeService::nsecs Now, RTT::os::TimeService::nsecs Silence);
+
+    /**
+     * \brief publishChanges
+     *
+     * Writes changed ADC and ENC channels of the frame.
+     */
+    void publishChanges( void);
+
+    /**
+     * \brief drainDIO
+     *
+     * Reads DIOInputPortWrite within the budget and the deadline,
+     * merges the commands and stages them once per bank.
+     *
+     * \param[in]	Deadline	Time at which reading stops, 0 for none
+     */
+    void drainDIO( RTT::os::TimeService::nsecs Deadline);
+
+    /**
+     * \brief drainDAC
+     *
+     * Same as \link drainDIO drainDIO \endlink for DACInputPort.
+     */
+    void drainDAC( RTT::os::TimeService::nsecs Deadline);
+
+    /**
+     * \brief adaptBudget
+     *
+     * Doubles the budget of a port when a command was left
+     * for the next cycle and halves it when it is mostly unused.
+     */
+    void adaptBudget( S626_drain_stats & Drain, unsigned int Count, bool Carried);
+
+    /**
+     * \brief engineOwnsTiming
+     *
+     * Logs an error and returns true when the board is serviced
+     * by an acquisition engine, whose thread sets period,
+     * priority and affinity of all its boards.
+     */
+    bool engineOwnsTiming(void);
+
+    /**
+     * \brief prepareSamples
+     *
+     * Sizes output samples according to selected
+     * channels and passes them to the ports.
+     * Builds ADCIndex and ENCIndex.
+     */
+    void prepareSamples( void);
+
     /**
      * \brief DIOInputPortWrite
      *
@@ -344,5 +993,62 @@ class S626_task : public RTT::TaskContext{
      */
     RTT::OutputPort <std::vector<int> > ENCOutputPort;
 
+    /**
+     * \brief FrameOutputPort
+     *
+     * Output port with the whole frame acquired by the interface
+     * thread: all DIO banks, ADC and ENC channels, masks of
+     * channels which were read, sequence number and acquisition
+     * timestamp.
+     *
+     * The sample has a fixed size and does not depend on
+     * selected channels.
+     */
+    RTT::OutputPort <S626_frame> FrameOutputPort;
+
+    /**
+     * \brief StatsOutputPort
+     *
+     * Output port with timing of the interface thread,
+     * see \link getCycleStats getCycleStats \endlink.
+     * Written every StatsPeriod seconds.
+     */
+    RTT::OutputPort <S626_cycle_stats> StatsOutputPort;
+
+    /**
+     * \brief DataAgeOutputPort
+     *
+     * Output port with the age of the published frame in seconds,
+     * time elapsed from the acquisition to the publishing.
+     * Written together with every published frame.
+     */
+    RTT::OutputPort <double> DataAgeOutputPort;
+
+    /**
+     * \brief DIOEdgeOutputPort
+     *
+     * Output port with an event for every DIO bank whose
+     * inputs changed between two reads. Nothing is written
+     * while the inputs are static.
+     */
+    RTT::OutputPort <S626_dio_edge> DIOEdgeOutputPort;
+
+    /**
+     * \brief ADCChangeOutputPort
+     *
+     * Output port with ADC channels which changed by more than
+     * their deadband, written in change publishing mode only
+     * when at least one channel changed.
+     */
+    RTT::OutputPort <S626_channel_update> ADCChangeOutputPort;
+
+    /**
+     * \brief ENCChangeOutputPort
+     *
+     * Same as \link ADCChangeOutputPort ADCChangeOutputPort \endlink
+     * for encoders.
+     */
+    RTT::OutputPort <S626_channel_update> ENCChangeOutputPort;
+
 };
 #endif
@@ -0,0 +1,185 @@
+/**
+ * \file s626_task-typekit.cpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <rtt/types/TypekitPlugin.hpp>
+#include <rtt/types/Types.hpp>
+#include <rtt/types/StructTypeInfo.hpp>
+#include <rtt/types/TemplateTypeInfo.hpp>
+
+#include <boost/serialization/serialization.hpp>
+#include <boost/serialization/array.hpp>
+
+#include "s626_task-types.hpp"
+
+namespace boost {
+namespace serialization {
+
+template<class Archive>
+void serialize(Archive & a, S626_frame & f, unsigned int version) {
+	using boost::serialization::make_nvp;
+	using boost::serialization::make_array;
+
+	a & make_nvp("seq", f.seq);
+	a & make_nvp("timestamp", f.timestamp);
+	a & make_nvp("cycle", f.cycle);
+	a & make_nvp("stale", f.stale);
+	a & make_nvp("ADCValid", f.ADCValid);
+	a & make_nvp("ENCValid", f.ENCValid);
+	a & make_nvp("DIOValid", f.DIOValid);
+	a & make_nvp("DIO", make_array(f.DIO, BOARD_DIO_BANKS));
+	a & make_nvp("ADC", make_array(f.ADC, BOARD_ADC_CHANNELS));
+	a & make_nvp("ENC", make_array(f.ENC, BOARD_ENC_CHANNELS));
+	a & make_nvp("DIOSeq", make_array(f.DIOSeq, BOARD_DIO_BANKS));
+	a & make_nvp("ADCSeq", make_array(f.ADCSeq, BOARD_ADC_CHANNELS));
+	a & make_nvp("ENCSeq", make_array(f.ENCSeq, BOARD_ENC_CHANNELS));
+}
+
+template<class Archive>
+void serialize(Archive & a, S626_group_frame & g, unsigned int version) {
+	using boost::serialization::make_nvp;
+	using boost::serialization::make_array;
+
+	a & make_nvp("seq", g.seq);
+	a & make_nvp("timestamp", g.timestamp);
+	a & make_nvp("boards", g.boards);
+	a & make_nvp("frames", make_array(g.frames, S626_GROUP_MAX_BOARDS));
+}
+
+template<class Archive>
+void serialize(Archive & a, S626_timing & t, unsigned int version) {
+	using boost::serialization::make_nvp;
+
+	a & make_nvp("count", t.count);
+	a & make_nvp("min", t.min);
+	a & make_nvp("max", t.max);
+	a & make_nvp("mean", t.mean);
+	a & make_nvp("p50", t.p50);
+	a & make_nvp("p90", t.p90);
+	a & make_nvp("p99", t.p99);
+	a & make_nvp("p999", t.p999);
+}
+
+template<class Archive>
+void serialize(Archive & a, S626_cycle_stats & s, unsigned int version) {
+	using boost::serialization::make_nvp;
+
+	a & make_nvp("period", s.period);
+	a & make_nvp("deadlineMisses", s.deadlineMisses);
+	a & make_nvp("wakeup", s.wakeup);
+	a & make_nvp("frame", s.frame);
+	a & make_nvp("scan", s.scan);
+	a & make_nvp("step", s.step);
+}
+
+template<class Archive>
+void serialize(Archive & a, S626_dio_edge & e, unsigned int version) {
+	using boost::serialization::make_nvp;
+
+	a & make_nvp("bank", e.bank);
+	a & make_nvp("changed", e.changed);
+	a & make_nvp("value", e.value);
+	a & make_nvp("timestamp", e.timestamp);
+	a & make_nvp("seq", e.seq);
+}
+
+template<class Archive>
+void serialize(Archive & a, S626_channel_update & u, unsigned int version) {
+	using boost::serialization::make_nvp;
+	using boost::serialization::make_array;
+
+	a & make_nvp("seq", u.seq);
+	a & make_nvp("timestamp", u.timestamp);
+	a & make_nvp("count", u.count);
+	a & make_nvp("channel", make_array(u.channel, BOARD_ADC_CHANNELS));
+	a & make_nvp("value", make_array(u.value, BOARD_ADC_CHANNELS));
+}
+
+template<class Archive>
+void serialize(Archive & a, S626_drain_stats & s, unsigned int version) {
+	using boost::serialization::make_nvp;
+
+	a & make_nvp("drained", s.drained);
+	a & make_nvp("coalesced", s.coalesced);
+	a & make_nvp("dropped", s.dropped);
+	a & make_nvp("carriedCycles", s.carriedCycles);
+	a & make_nvp("budget", s.budget);
+	a & make_nvp("peak", s.peak);
+}
+
+}
+}
+
+/**
+ * \brief S626_taskTypekit
+ *
+ * Registers types published by S626_task and S626_group
+ */
+class S626_taskTypekit: public RTT::types::TypekitPlugin {
+public:
+
+	bool loadTypes() {
+		//older RTT versions do not know 64 bit integers used in timestamps
+		if (RTT::types::Types()->getTypeInfo<long long>() == 0)
+			RTT::types::Types()->addType(
+					new RTT::types::TemplateTypeInfo<long long, true>("llong"));
+
+		RTT::types::Types()->addType(
+				new RTT::types::StructTypeInfo<S626_frame>("S626_frame"));
+		RTT::types::Types()->addType(
+				new RTT::types::StructTypeInfo<S626_group_frame>(
+						"S626_group_frame"));
+		RTT::types::Types()->addType(
+				new RTT::types::StructTypeInfo<S626_timing>("S626_timing"));
+		RTT::types::Types()->addType(
+				new RTT::types::StructTypeInfo<S626_cycle_stats>(
+						"S626_cycle_stats"));
+		RTT::types::Types()->addType(
+				new RTT::types::StructTypeInfo<S626_dio_edge>("S626_dio_edge"));
+		RTT::types::Types()->addType(
+				new RTT::types::StructTypeInfo<S626_channel_update>(
+						"S626_channel_update"));
+		RTT::types::Types()->addType(
+				new RTT::types::StructTypeInfo<S626_drain_stats>(
+						"S626_drain_stats"));
+
+		return true;
+	}
+
+	bool loadOperators() {
+		return true;
+	}
+
+	bool loadConstructors() {
+		return true;
+	}
+
+	std::string getName() {
+		return "s626_task";
+	}
+};
+
+ORO_TYPEKIT_PLUGIN(S626_taskTypekit)
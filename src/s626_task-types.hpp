@@ -0,0 +1,310 @@
+/**
+ * \file s626_task-types.hpp
+ *
+ * \author Wojciech Domski
+ *
+ */
+
+/***************************************************************************
+ *   Copyright (C) 2014 by Wojciech Domski                                 *
+ *   Wojciech.Domski@gmail.com                                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef OROCOS_S626_TASK_TYPES_HPP
+#define OROCOS_S626_TASK_TYPES_HPP
+
+#include "Board-backend.hpp"
+
+/**
+ * Maximal number of boards in S626_group_frame
+ */
+#define S626_GROUP_MAX_BOARDS 8
+
+/**
+ * \brief S626_frame
+ *
+ * Snapshot of all the peripherals read by Interface_thread
+ * during a single cycle.
+ *
+ * Plain fixed size structure, so it is published through
+ * the ports without any allocation and its layout does
+ * not depend on selected channels.
+ */
+struct S626_frame {
+	/**
+	 * Number of the cycle which produced the frame
+	 */
+	unsigned int seq;
+
+	/**
+	 * Time of the acquisition in nanoseconds,
+	 * RTT::os::TimeService clock
+	 */
+	long long timestamp;
+
+	/**
+	 * Number of the cycle of the thread which read the frame,
+	 * the same for all boards read by one Acquisition_engine
+	 */
+	unsigned int cycle;
+
+	/**
+	 * Number of consecutive cycles in which the board could not be
+	 * read, 0 for fresh data. Stale frames repeat the last values
+	 * and timestamp with no channel marked as read.
+	 */
+	unsigned int stale;
+
+	/**
+	 * Channels of ADC which were read in this frame,
+	 * each bit corresponds to a channel
+	 */
+	unsigned int ADCValid;
+
+	/**
+	 * Channels of ENC which were read
+	 */
+	unsigned int ENCValid;
+
+	/**
+	 * Banks of DIO which were read
+	 */
+	unsigned int DIOValid;
+
+	/**
+	 * Values of the DIO banks
+	 */
+	int DIO[BOARD_DIO_BANKS];
+
+	/**
+	 * Values of the ADC channels, from 0 to 2^14 - 1
+	 */
+	int ADC[BOARD_ADC_CHANNELS];
+
+	/**
+	 * Values of the encoder counters
+	 */
+	int ENC[BOARD_ENC_CHANNELS];
+
+	/**
+	 * Sequence number of the frame in which each value
+	 * was read, channels may be read at lower rates
+	 */
+	unsigned int DIOSeq[BOARD_DIO_BANKS];
+
+	unsigned int ADCSeq[BOARD_ADC_CHANNELS];
+
+	unsigned int ENCSeq[BOARD_ENC_CHANNELS];
+};
+
+/**
+ * \brief S626_group_frame
+ *
+ * Frames of all the boards serviced by one Acquisition_engine,
+ * read in the same cycle.
+ */
+struct S626_group_frame {
+	/**
+	 * Number of the cycle of the engine
+	 */
+	unsigned int seq;
+
+	/**
+	 * Time of the acquisition shared by all the frames
+	 */
+	long long timestamp;
+
+	/**
+	 * Number of valid entries of frames
+	 */
+	unsigned int boards;
+
+	/**
+	 * Frames in the order the boards were attached to the engine.
+	 * A frame with cycle different from seq was not read in this
+	 * cycle and holds the last values of the board.
+	 */
+	S626_frame frames[S626_GROUP_MAX_BOARDS];
+};
+
+/**
+ * \brief S626_timing
+ *
+ * Summary of a cycle time histogram, all values in nanoseconds.
+ * Percentiles are upper bounds of log scale buckets.
+ */
+struct S626_timing {
+	unsigned int count;
+
+	long long min;
+
+	long long max;
+
+	long long mean;
+
+	long long p50;
+
+	long long p90;
+
+	long long p99;
+
+	long long p999;
+};
+
+/**
+ * \brief S626_cycle_stats
+ *
+ * Timing of Interface_thread cycles.
+ */
+struct S626_cycle_stats {
+	/**
+	 * Period of the interface thread in nanoseconds
+	 */
+	long long period;
+
+	/**
+	 * Number of cycles which finished after the next
+	 * cycle should have started
+	 */
+	unsigned int deadlineMisses;
+
+	/**
+	 * Delay of the wake-up against the ideal periodic release
+	 */
+	S626_timing wakeup;
+
+	/**
+	 * Batched read of DIO, ENC and ADC frame
+	 */
+	S626_timing frame;
+
+	/**
+	 * Consumption of the hardware ADC scan
+	 */
+	S626_timing scan;
+
+	/**
+	 * Whole step of the interface thread
+	 */
+	S626_timing step;
+};
+
+/**
+ * \brief S626_dio_edge
+ *
+ * Change of inputs of a DIO bank between two reads.
+ */
+struct S626_dio_edge {
+	/**
+	 * Bank number 0-2
+	 */
+	unsigned int bank;
+
+	/**
+	 * Bits which toggled, rising edges are changed & value
+	 * and falling edges changed & ~value
+	 */
+	unsigned int changed;
+
+	/**
+	 * New value of the bank
+	 */
+	unsigned int value;
+
+	/**
+	 * Time of the read which detected the change
+	 */
+	long long timestamp;
+
+	/**
+	 * Sequence number of the frame with the new value
+	 */
+	unsigned int seq;
+};
+
+/**
+ * \brief S626_channel_update
+ *
+ * Channels of a peripheral which changed by more than their
+ * deadband or reached the heartbeat interval, the first
+ * count entries of channel and value are valid.
+ */
+struct S626_channel_update {
+	/**
+	 * Sequence number of the frame
+	 */
+	unsigned int seq;
+
+	/**
+	 * Time of the acquisition of the frame
+	 */
+	long long timestamp;
+
+	unsigned int count;
+
+	unsigned int channel[BOARD_ADC_CHANNELS];
+
+	int value[BOARD_ADC_CHANNELS];
+};
+
+#define S626_DRAIN_DIO 0
+#define S626_DRAIN_DAC 1
+#define S626_DRAIN_PORTS 2
+
+/**
+ * \brief S626_drain_stats
+ *
+ * Accounting of commands read from an input port
+ * by S626_task::updateHook.
+ */
+struct S626_drain_stats {
+	/**
+	 * Commands read from the port
+	 */
+	unsigned int drained;
+
+	/**
+	 * Channel or bank writes overridden by a later
+	 * command read in the same cycle
+	 */
+	unsigned int coalesced;
+
+	/**
+	 * Malformed commands
+	 */
+	unsigned int dropped;
+
+	/**
+	 * Cycles which reached the budget or the deadline while
+	 * another command was waiting, it is carried over to the
+	 * next cycle
+	 */
+	unsigned int carriedCycles;
+
+	/**
+	 * Current maximal number of commands read in a cycle
+	 */
+	unsigned int budget;
+
+	/**
+	 * Most commands read in a single cycle
+	 */
+	unsigned int peak;
+};
+
+#endif